@@ -12,13 +12,26 @@
 #define ASTROQUT_WS_ASTROQUT_HPP
 
 #include "fista/poisson.hpp"
+#include "newton/poisson.hpp"
 #include "utils/linearop/matrix.hpp"
+#include "utils/linearop/operator/abeltransform.hpp"
+#include "utils/linearop/operator/blurring.hpp"
 
 namespace alias
 {
 namespace WS
 {
 
+/** Operator used to refit the non-zero elements
+ */
+enum RefitOperator {explicit_columns, //!< columns of the AstroOperator computed once and stored, fastest products
+                    matrix_free};     //!< AstroOperator applied on the support at every product, memory independent of the support size
+
+/** Solver used to refit the non-zero elements
+ */
+enum RefitSolver {first_order,   //!< FISTA without regularization
+                  second_order}; //!< projected Newton, a Cholesky factorization of the weighted Gram matrix per iteration
+
 template<class T = double>
 struct Parameters
 {
@@ -29,6 +42,8 @@ struct Parameters
         : pic_size(0)
         , model_size(0)
         , blurring_filter(std::string("data/blurring.data"))
+        , blurring_backend(blurring_auto)
+        , blurring_tolerance(1e-3)
         , bootstrap_max(1)
         , wavelet{3,8}
         , resample_windows_size(4)
@@ -37,6 +52,10 @@ struct Parameters
         , MC_quantile_PS(999)
         , beta0(std::numeric_limits<double>::infinity())
         , lambda(1.0)
+        , refit_operator(matrix_free)
+        , refit_solver(second_order)
+        , abel_storage(abel_full)
+        , precompose_spline(false)
         , standardize{}
         , fista_params{}
     {
@@ -57,6 +76,8 @@ struct Parameters
     size_t pic_size; //!< Member variable "pic_size" side of picture in pixel
     size_t model_size; //!< Member variable "model_size" wavelet + spline + point sources
     std::string blurring_filter; //!< Member variable "blurring_filter" path to the blurring filter data file
+    BlurringBackend blurring_backend; //!< Member variable "blurring_backend" backend of the blurring operator, measured at construction if blurring_auto
+    double blurring_tolerance; //!< Member variable "blurring_tolerance" relative Frobenius error allowed on the filter by blurring_separable
     size_t bootstrap_max; //!< Member variable "bootstrap_max" total amount of bootstraps computations, 0 for no bootstrapping
     size_t wavelet[2]; //!< Member variable "wavelet" wavelet type and wavelet parameter
     size_t resample_windows_size; //!< Member variable "resample_windows_size" side size of the resampling square
@@ -65,15 +86,28 @@ struct Parameters
     size_t MC_quantile_PS; //!< Member variable "MC_quantile_PS" quantile for lambdaI
     T beta0; //!< Member variable "beta0" intercept
     T lambda; //!< Member variable "lambda" first regularization parameter
+    RefitOperator refit_operator; //!< Member variable "refit_operator" operator of the non-zero elements refit, the second order solver always uses explicit_columns
+    RefitSolver refit_solver; //!< Member variable "refit_solver" solver of the non-zero elements refit
+    AbelStorage abel_storage; //!< Member variable "abel_storage" precision of the stored Abel matrix
+    bool precompose_spline; //!< Member variable "precompose_spline" apply the spline coefficients with one sweep of the Abel transform times spline table, about four times the memory of the Abel table
     Matrix<T> standardize; //!< Member variable "standardize" standardisation matrix
     fista::poisson::Parameters<T> fista_params; //!< Member variable "fista_params" parameters to be given to the FISTA solver
 };
 
-Matrix<double> Solve(std::string picture_path,
-                     std::string sensitivity_path,
-                     std::string background_path,
-                     std::string solution_path,
-                     Parameters<double>& options );
+/** AstroQUT solver
+ *  \param picture_path Path to the picture
+ *  \param sensitivity_path Path to the sensitivity of the picture
+ *  \param background_path Path to the background of the picture
+ *  \param solution_path Path to the file to write the solutions to
+ *  \param options Parameters of the solver, T selects the precision of the whole pipeline, instantiated for float and double
+ *  \return The cropped solution of each bootstrap, one per row
+ */
+template<class T>
+Matrix<T> Solve(std::string picture_path,
+                std::string sensitivity_path,
+                std::string background_path,
+                std::string solution_path,
+                Parameters<T>& options );
 
 } // namespace WS
 } // namespace alias
@@ -15,7 +15,6 @@
 //#define SILENT
 //#define DO_ARGCHECKS
 //#define CLASSIC_FISTA
-#define BLURRING_CONVOLUTION
 
 #define PI 3.14159265358979323846264338328
 
@@ -12,13 +12,20 @@
 #define ASTROQUT_FISTA_POISSON_HPP
 
 #include "utils/linearop/matrix.hpp"
+#include "utils/linearop/matrix/expression.hpp"
+#include "utils/linearop/matrix/view.hpp"
 #include "utils/linearop/operator/matmult.hpp"
 #include "utils/linearop/operator/convolution.hpp"
+#include "utils/memorypool.hpp"
+#include "utils/workspace.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <limits>
 #include <numeric>
+#include <vector>
 
 namespace alias
 {
@@ -27,6 +34,14 @@ namespace fista
 namespace poisson
 {
 
+/** Range [first, last) of elements of x
+ */
+struct Range
+{
+    size_t first; //!< Member variable "first"
+    size_t last; //!< Member variable "last" one past the last element
+};
+
 template<class T = double>
 struct Parameters
 {
@@ -37,7 +52,7 @@ struct Parameters
         : tol(1e-6)
         , iter_max(1000)
         , init_value{}
-        , indices(Matrix<size_t>(0,1,1))
+        , non_negative{Range{0,1}}
         , log(true)
         , log_period(20)
     {}
@@ -45,7 +60,7 @@ struct Parameters
     T tol; //!< Member variable "tol"
     size_t iter_max; //!< Member variable "iter_max"
     Matrix<T> init_value; //!< Member variable "init_value"
-    Matrix<size_t> indices; //!< Member variable "indices"
+    std::vector<Range> non_negative; //!< Member variable "non_negative" ranges of x constrained to non-negative values
     bool log; //!< Member variable "log"
     unsigned int log_period; //!< Member variable "log_period"
 };
@@ -58,11 +73,11 @@ struct Parameters
  *  \param options Parameters that defines various value for FISTA to work
  */
 template<class T>
-T Func(const Matrix<T>& Axu,
-       const Matrix<T>& b )
+double Func(const Matrix<T>& Axu,
+            const Matrix<T>& b )
 {
     // sum(A*x+u - b.*log(A*x+u))
-    return (Axu - (b & (Axu.Log()))).Sum();
+    return Sum(Lazy(Axu) - (b & Log(Lazy(Axu))));
 }
 template<class T>
 Matrix<T> FuncGrad(const Matrix<T>& Axu,
@@ -70,30 +85,105 @@ Matrix<T> FuncGrad(const Matrix<T>& Axu,
                    const Matrix<T>& b )
 {
     // A' * ((A*x+u - b) ./ (A*x+u))
-    return At * ((Axu - b) / Axu);
+    return At * ((Lazy(Axu) - b) / Axu);
+}
+template<class T>
+void FuncGrad(const Matrix<T>& Axu,
+              const Operator<T>& At,
+              const Matrix<T>& b,
+              Matrix<T>& residual,
+              Matrix<T>& grad,
+              Workspace& workspace )
+{
+    // A' * ((A*x+u - b) ./ (A*x+u)), the residual and the gradient are overwritten
+    residual = (Lazy(Axu) - b) / Axu;
+    At.Apply(residual, grad, workspace);
 }
 template<class T>
-T FLasso(const Matrix<T>& Axu,
-         const Matrix<T>& x_woi,
-         const Matrix<T>& b,
-         T lambda )
+double FLasso(const Matrix<T>& Axu,
+              const Matrix<T>& x_woi,
+              const Matrix<T>& b,
+              T lambda )
 {
     // sum(A*x+u - b.*log(A*x+u)) + lambda * norm(x[-0],1)
     return Func(Axu, b) + lambda*x_woi.Norm(one);
 }
 template<class T>
-T FLassoApprox(const Matrix<T>& Ayu,
-               const Operator<T>& At,
-               const Matrix<T>& x,
-               const Matrix<T>& x_woi,
-               const Matrix<T>& y,
-               const Matrix<T>& b,
-               T lambda,
-               T L )
+double FLassoApprox(double func_y,
+                    const Matrix<T>& grad_y,
+                    const Matrix<T>& x,
+                    const Matrix<T>& y,
+                    T lambda,
+                    T L )
+{
+    // sum(A*y+u - b.*log(A*y+u)) + <(x-y), gradfunc(A,y,u,b,w)> + 0.5*L*||x-y||^2  + lambda * norm(x[-0],1)
+    // func_y and grad_y do not depend on x, the inner product, the squared norm and the one norm are fused
+    // in a single sweep as <(x-y), gradfunc(A,y,u,b,w) + 0.5*L*(x-y)> + lambda * norm(x[-0],1)
+    const T* x_data = x.Data();
+    const T* y_data = y.Data();
+    const T* grad_data = grad_y.Data();
+    const T half_L = (T)0.5*L;
+    return func_y + reduction::Sum<double>(x.Length(), [=](size_t i)
+    {
+        T x_minus_y = x_data[i] - y_data[i];
+        return (double) (x_minus_y * (grad_data[i] + half_L * x_minus_y)) + (i == 0 ? 0.0 : (double) (lambda * std::abs(x_data[i])));
+    });
+}
+/** Proximal gradient step
+ *  \brief Gradient step, soft thresholding of every element but the first and projection of the non-negative
+ *  ranges in a single pass, i.e. x = max(shrink(y - grad/L, lambda/L), 0)
+ *  \param y Point of the gradient step
+ *  \param grad Gradient at y
+ *  \param lambda Regularization parameter
+ *  \param L Lipschitz constant estimate
+ *  \param non_negative Ranges of x constrained to non-negative values
+ *  \param x Result, same size as y
+ */
+template<class T>
+void ProximalGradient(const Matrix<T>& y,
+                      const Matrix<T>& grad,
+                      T lambda,
+                      T L,
+                      const std::vector<Range>& non_negative,
+                      Matrix<T>& x )
 {
-    // sum(A*x+u - b.*log(A*x+u)) + <(x-y), gradfunc(A,y,u,b,w)> + 0.5*L*||x-y||^2  + lambda * norm(x[-0],1)
-    return Func(Ayu, b) + Inner( x-y, FuncGrad(Ayu, At, b) ) + 0.5*L*(x-y).Norm(two_squared) + lambda*x_woi.Norm(one);
+    const size_t length = y.Length();
+    const T* y_data = y.Data();
+    const T* grad_data = grad.Data();
+    T* x_data = x.Data();
+    const T step = (T)1 / L;
+    const T threshold = lambda / L;
+
+    // split x into segments with the same constraints, the first element is not shrunk
+    std::vector<size_t> bounds = {0, std::min((size_t)1, length), length};
+    for( const Range& range : non_negative )
+    {
+        bounds.push_back(std::min(range.first, length));
+        bounds.push_back(std::min(range.last, length));
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    for( size_t segment = 0; segment + 1 < bounds.size(); ++segment )
+    {
+        const size_t first = bounds[segment];
+        const size_t last = bounds[segment+1];
+        const bool shrink = first != 0;
+        const bool clamp = std::any_of(non_negative.begin(), non_negative.end(), [first](const Range& range){ return range.first <= first && first < range.last; });
+
+        #pragma omp parallel for simd
+        for( size_t i = first; i < last; ++i )
+        {
+            T value = y_data[i] - grad_data[i] * step;
+            if( shrink )
+                value = std::copysign(std::max(std::abs(value) - threshold, (T)0), value);
+            if( clamp )
+                value = std::max(value, (T)0);
+            x_data[i] = value;
+        }
+    }
 }
+
 template<class T>
 Matrix<T> Solve(const Operator<T>& A,
                 const Matrix<T>& u,
@@ -101,6 +191,14 @@ Matrix<T> Solve(const Operator<T>& A,
                 T lambda,
                 const Parameters<T>& options )
 {
+    // recycle the temporaries of the iterations instead of going back to the system allocator
+    MemoryPool::Scope pool_scope;
+    size_t allocations_start = MemoryPool::Instance().Allocations();
+    size_t allocations_avoided_start = MemoryPool::Instance().AllocationsAvoided();
+
+    // the operator is applied out-of-place into the buffers below, its temporaries live in the workspace
+    Workspace workspace;
+
     std::cout << std::defaultfloat;
     std::cout << std::string(37, '*') << " FISTA " << std::string(36, '*') << std::endl;
     std::cout << "A: " << A.Height() << "x" << A.Width() << " matrix";
@@ -117,22 +215,28 @@ Matrix<T> Solve(const Operator<T>& A,
     if( !options.init_value.IsEmpty() )
         x = options.init_value;
     Matrix<T> x_next(x);
-    Matrix<T> x_next_woi(x_next.Data()+1, x_next.Height()-1, 1); // points to second element of x_next;
+    Matrix<T> x_next_woi = MatrixView<T>(x_next).Segment(1, x_next.Height()-1).Borrow(); // points to second element of x_next
     Matrix<T> y(x);
 
     // intermediate results
-    Matrix<T> Axu = A*x+u;
-    Matrix<T> Ax_nextu;
-    Matrix<T> Ayu = Axu;
+    Matrix<T> Axu(A.Height(), 1);
+    A.Apply(x, Axu, workspace);
+    Axu += u;
+    Matrix<T> Ax_nextu(A.Height(), 1);
+    Matrix<T> Ayu(Axu);
+    Matrix<T> residual(A.Height(), 1);
+    Matrix<T> grad_y(A.Width(), 1);
+    Matrix<T> grad_current(A.Width(), 1);
     Operator<T> *A_copy = A.Clone();
     Operator<T> &At = A_copy->Transpose();
-    T f_lasso_next = (T)0;
-    T f_lasso_previous[10] {};
+    // objective values are kept in double precision, their differences drive the backtracking and the stopping criterion
+    double f_lasso_next = 0.0;
+    double f_lasso_previous[10] {};
     f_lasso_previous[0] = FLasso(Axu, x_next_woi, b, lambda);
-    Matrix<T> grad_current = FuncGrad(Axu, At, b);
+    FuncGrad(Axu, At, b, residual, grad_current, workspace);
 
     // FISTA variables
-    T tol = std::numeric_limits<T>::infinity();
+    double tol = std::numeric_limits<double>::infinity();
     T Lf = (T)1;
     T eta = (T)2;
     T L_bar = (T)0;
@@ -145,40 +249,43 @@ Matrix<T> Solve(const Operator<T>& A,
     // main loop
     while( std::abs(tol) > options.tol && k < options.iter_max )
     {
+        // the quadratic approximation is built around y, it does not change during backtracking
+        double func_y = Func(Ayu, b);
+        FuncGrad(Ayu, At, b, residual, grad_y, workspace);
+
         // backtracking loop
-        T beta = std::numeric_limits<T>::infinity();
+        double beta = std::numeric_limits<double>::infinity();
         for( int ik = 0; beta > 0; ++ik )
         {
             L_bar = std::pow(eta, ik) * Lf;
-            x_next = y - (grad_current/L_bar);
-            x_next_woi.Data(x_next.Data()+1); // points to second element of new x_next
-            std::move(x_next_woi).Shrink(lambda/L_bar); //cast to an rvalue to allow in-place shrinkage
-            std::move(x_next).RemoveNeg(options.indices);
-            Ax_nextu = (A*x_next)+u;
+            ProximalGradient(y, grad_current, lambda, L_bar, options.non_negative, x_next);
+            A.Apply(x_next, Ax_nextu, workspace);
+            Ax_nextu += u;
             if( Ax_nextu.ContainsNeg() ) // skip function evaluation if we have negative values
                 continue;
             f_lasso_next = FLasso(Ax_nextu, x_next_woi, b, lambda);
-            beta = f_lasso_next - FLassoApprox(Ayu, At, x_next, x_next_woi, y, b, lambda, L_bar);
+            beta = f_lasso_next - FLassoApprox(func_y, grad_y, x_next, y, lambda, L_bar);
         }
 
         // FISTA step
 #ifdef CLASSIC_FISTA
-        y = x_next + (x_next - x) * ((t - 1.0)/t_next);
+        y = Lazy(x_next) + (Lazy(x_next) - x) * ((t - 1.0)/t_next);
 #else
-        y = x_next;
+        std::copy(x_next.Data(), x_next.Data() + x_next.Length(), y.Data());
 #endif // CLASSIC_FISTA
 
         // compute tol from previous function value
-        T f_lasso_previous_sum = std::accumulate(f_lasso_previous, f_lasso_previous+10, (T)0) / std::min((T) k+1, (T)10);
+        double f_lasso_previous_sum = std::accumulate(f_lasso_previous, f_lasso_previous+10, 0.0) / std::min((double) k+1, 10.0);
         tol = std::abs( f_lasso_next - f_lasso_previous_sum ) / f_lasso_previous_sum;
 
         // actualize values for next iteration
         ++k;
-        x = x_next;
-        Axu = Ax_nextu;
-        Ayu = A*y+u;
+        std::copy(x_next.Data(), x_next.Data() + x_next.Length(), x.Data());
+        swap(Axu, Ax_nextu);
+        A.Apply(y, Ayu, workspace);
+        Ayu += u;
         f_lasso_previous[k % 10] = f_lasso_next;
-        grad_current = FuncGrad(Axu, At, b);
+        FuncGrad(Axu, At, b, residual, grad_current, workspace);
 #ifdef CLASSIC_FISTA
         t = t_next;
         t_next = (1.0L + std::sqrt(1.0L + 4.0L * t * t)) / 2.0L;
@@ -208,9 +315,11 @@ Matrix<T> Solve(const Operator<T>& A,
     else
         std::cout << "FISTA: did not converge after " << k << " iterations" << std::endl;
 
-    std::cout << "FISTA: Relative error: " << std::abs(tol) << std::endl << std::endl;
+    std::cout << "FISTA: Relative error: " << std::abs(tol) << std::endl;
+    std::cout << "FISTA: Allocations avoided: " << MemoryPool::Instance().AllocationsAvoided() - allocations_avoided_start;
+    std::cout << " out of " << MemoryPool::Instance().Allocations() - allocations_start;
+    std::cout << ", workspace blocks: " << workspace.Allocations() << std::endl << std::endl;
 
-    x_next_woi.Data(nullptr); // release pointer
     delete A_copy;
 
     return x;
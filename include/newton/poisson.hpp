@@ -0,0 +1,198 @@
+///
+/// \file include/newton/poisson.hpp
+/// \brief Projected Newton solver for Poisson distributed noise without regularization.
+/// \details Second order solver of the non-penalized Poisson regression, used to refit the non-zero elements.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_NEWTON_POISSON_HPP
+#define ASTROQUT_NEWTON_POISSON_HPP
+
+#include "fista/poisson.hpp"
+#include "utils/linearop/matrix/cholesky.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace alias
+{
+namespace newton
+{
+namespace poisson
+{
+
+inline constexpr double armijo = 1e-4; //!< Fraction of the first order decrease required by the line search
+inline constexpr size_t line_search_max = 50; //!< Halvings of the step before giving up
+
+/** Projected Newton solver for Poisson distributed noise
+ *  \brief Minimizes sum(A*x+u - b.*log(A*x+u)) with the non-negative ranges of x as bound constraints.
+ *  Every iteration fixes the constrained elements at zero whose gradient points outwards, solves the Newton system
+ *  A_F' * diag(b./(A*x+u).^2) * A_F * d_F = -grad_F on the other ones through a Cholesky factorization,
+ *  and projects back onto the constraints during an Armijo backtracking line search.
+ *  \param A Regression operator, its WeightedGram is computed once per iteration
+ *  \param u Background shift
+ *  \param b Response data to the regression matrix
+ *  \param options Parameters shared with the FISTA solver, tol applies to the Newton decrement relative to the objective
+ *  \return The solution, the FISTA solution without regularization if A*init_value+u is not positive
+ */
+template<class T>
+Matrix<T> Solve(const Operator<T>& A,
+                const Matrix<T>& u,
+                const Matrix<T>& b,
+                const fista::poisson::Parameters<T>& options )
+{
+    MemoryPool::Scope pool_scope;
+
+    const size_t width = A.Width();
+    std::vector<bool> constrained(width, false);
+    for( const fista::poisson::Range& range : options.non_negative )
+        for( size_t i = range.first; i < std::min(range.last, width); ++i )
+            constrained[i] = true;
+
+    // starting point projected onto the constraints
+    Matrix<T> x((T)0, width, 1);
+    if( !options.init_value.IsEmpty() )
+        x = options.init_value;
+    for( size_t i = 0; i < width; ++i )
+        if( constrained[i] )
+            x[i] = std::max(x[i], (T)0);
+
+    Matrix<T> Axu = A*x+u;
+    if( !(Axu.Min() > (T)0) )
+    {
+        std::cout << "Newton: the starting point gives non-positive intensities, falling back to FISTA" << std::endl;
+        return fista::poisson::Solve(A, u, b, (T)0, options);
+    }
+
+    std::cout << std::defaultfloat;
+    std::cout << std::string(36, '*') << " Newton " << std::string(36, '*') << std::endl;
+    std::cout << "A: " << A.Height() << "x" << A.Width() << " matrix";
+    std::cout << ", u: " << u.Length() << " vector";
+    std::cout << ", b: " << b.Length() << " vector" << std::endl;
+    std::cout << "tol:" << options.tol << std::endl;
+    std::cout << std::string(80, '*') << std::endl << std::endl;
+    std::cout << " iter" << " | " << "     decrement      " << " | " << "         F          " << " | " << "    step     " << " | " << "  free  " << std::endl;
+    std::cout << std::string(80, '-') << std::endl;
+    std::cout << std::scientific;
+
+    Operator<T> *A_copy = A.Clone();
+    Operator<T> &At = A_copy->Transpose();
+
+    double func = fista::poisson::Func(Axu, b);
+    double decrement = std::numeric_limits<double>::infinity();
+    size_t k = 0;
+    bool converged = false;
+
+    while( k < options.iter_max )
+    {
+        Matrix<T> grad = fista::poisson::FuncGrad(Axu, At, b);
+
+        // Hessian weights b./(A*x+u).^2
+        Matrix<T> weights(b.Height(), 1);
+        #pragma omp parallel for simd
+        for( size_t i = 0; i < b.Length(); ++i )
+            weights[i] = b[i] / (Axu[i] * Axu[i]);
+        Matrix<T> hessian = A.WeightedGram(weights);
+
+        // free elements, the constrained ones at zero with a positive gradient stay fixed
+        std::vector<size_t> free_elements;
+        for( size_t i = 0; i < width; ++i )
+            if( !(constrained[i] && x[i] <= (T)0 && grad[i] > (T)0) )
+                free_elements.push_back(i);
+        const size_t free_amount = free_elements.size();
+        if( free_amount == 0 )
+        {
+            converged = true;
+            break;
+        }
+
+        // Newton system on the free elements, damped until it is numerically positive definite
+        T diagonal_max = 0;
+        for( size_t i : free_elements )
+            diagonal_max = std::max(diagonal_max, hessian[i*width + i]);
+        T damping = 0;
+        Matrix<T> factor(free_amount, free_amount);
+        while( true )
+        {
+            #pragma omp parallel for
+            for( size_t i = 0; i < free_amount; ++i )
+                for( size_t j = 0; j < free_amount; ++j )
+                    factor[i*free_amount + j] = hessian[free_elements[i]*width + free_elements[j]] + (i == j ? damping : (T)0);
+            if( Cholesky(factor) )
+                break;
+            damping = std::max(damping * (T)10, (diagonal_max > (T)0 ? diagonal_max : (T)1) * std::numeric_limits<T>::epsilon() * (T)100);
+        }
+        Matrix<T> direction(free_amount, 1);
+        for( size_t i = 0; i < free_amount; ++i )
+            direction[i] = -grad[free_elements[i]];
+        CholeskySolve(factor, direction);
+
+        decrement = 0.0;
+        for( size_t i = 0; i < free_amount; ++i )
+            decrement -= (double) grad[free_elements[i]] * direction[i];
+        if( decrement * 0.5 <= options.tol * std::abs(func) )
+        {
+            converged = true;
+            break;
+        }
+
+        // backtracking on the projected path
+        Matrix<T> x_next(x);
+        Matrix<T> Ax_nextu;
+        double func_next = func;
+        double step = 2.0;
+        bool accepted = false;
+        for( size_t ls = 0; ls < line_search_max && !accepted; ++ls )
+        {
+            step *= 0.5;
+            for( size_t i = 0; i < free_amount; ++i )
+            {
+                const size_t index = free_elements[i];
+                T value = x[index] + (T)step * direction[i];
+                x_next[index] = constrained[index] ? std::max(value, (T)0) : value;
+            }
+            Ax_nextu = A*x_next+u;
+            if( !(Ax_nextu.Min() > (T)0) )
+                continue;
+            func_next = fista::poisson::Func(Ax_nextu, b);
+            double first_order = 0.0;
+            for( size_t i : free_elements )
+                first_order += (double) grad[i] * (x_next[i] - x[i]);
+            accepted = func_next <= func + armijo * first_order;
+        }
+        if( !accepted )
+            break;
+
+        ++k;
+        x = x_next;
+        Axu = Ax_nextu;
+        func = func_next;
+
+        if( options.log )
+            std::cout << std::setw(5) << k << " | " << std::scientific << std::setprecision(10) << std::setw(20) << decrement << " | " << std::setw(20) << func << " | " << std::setw(13) << step << " | " << std::setw(8) << free_amount << std::endl;
+    }
+
+    std::cout << std::string(80, '-') << std::endl;
+    if( converged )
+        std::cout << "Newton: converged in " << k << " iterations" << std::endl;
+    else
+        std::cout << "Newton: did not converge after " << k << " iterations" << std::endl;
+    std::cout << "Newton: decrement: " << decrement << std::endl << std::endl;
+
+    delete A_copy;
+
+    return x;
+}
+
+} // namespace poisson
+} // namespace newton
+} // namespace alias
+
+#endif // ASTROQUT_NEWTON_POISSON_HPP
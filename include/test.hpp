@@ -31,6 +31,7 @@ bool MatrixTest()
 
     bool transpose_square = TransposeSquare<T>();
     bool transpose_rect = TransposeRect<T>();
+    bool transpose_in_place = TransposeInPlace<T>();
 
     bool add = Add<T>();
     bool sub = Sub<T>();
@@ -47,17 +48,30 @@ bool MatrixTest()
 
     bool shrink = Shrink<T>();
 
+    bool expression = Expression<T>();
+
     bool input = Input();
+    bool input_binary = InputBinaryFile();
+
+    bool view = View();
+
+    bool pool = Pool();
+
+    bool reduction = Reduction();
 
     bool cc = CC<T>();
+    bool cc_large = CCLarge();
+
+    bool cholesky = CholeskyTest();
 
-    return transpose_square && transpose_rect && add && sub && mult_square && mult_rect && vect_mat && mat_vect && norm_one && norm_two && norm_inf && sum && shrink && input && cc;
+    return transpose_square && transpose_rect && transpose_in_place && add && sub && mult_square && mult_rect && vect_mat && mat_vect && norm_one && norm_two && norm_inf && sum && shrink && expression && input && input_binary && view && pool && reduction && cc && cc_large && cholesky;
 }
 
 template <class T>
 void PerfTestOptional(size_t length)
 {
     matrix::Optimizations<T>(length);
+    matrix::MultOptimizations<T>(512);
 }
 
 bool OperatorTest();
@@ -11,6 +11,9 @@
 #define ASTROQUT_TEST_FISTA_HPP
 
 #include "fista/poisson.hpp"
+#include "newton/poisson.hpp"
+#include "utils/linearop/operator/astrooperator.hpp"
+#include "utils/linearop/operator/hybridmatmult.hpp"
 
 #include <chrono>
 #include <iostream>
@@ -24,6 +27,9 @@ namespace fista
 {
 
 bool SmallExample();
+bool Proximal();
+bool SinglePrecision();
+bool Newton();
 
 void Time(size_t length);
 
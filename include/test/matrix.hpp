@@ -11,6 +11,8 @@
 #define ASTROQUT_TEST_MATRIX_HPP
 
 #include "utils/linearop/matrix.hpp"
+#include "utils/linearop/matrix/cholesky.hpp"
+#include "utils/linearop/matrix/expression.hpp"
 
 #include <chrono>
 #include <iostream>
@@ -98,6 +100,55 @@ void Optimizations(size_t length)
     std::cout << "Time for omp taskloop simd to assign " << length << " " << type << " : " << elapsed_time.count() << " seconds" << std::endl;
 }
 
+template <class T>
+void MultOptimizations(size_t size)
+{
+    std::string type(typeid(T).name());
+    Matrix<T> first(size, size);
+    Matrix<T> second(size, size);
+    Matrix<T> vect(size, 1);
+    Matrix<T> vect_transposed(1, size);
+    for(size_t i = 0; i < first.Length(); ++i)
+    {
+        first[i] = (T) ((i % 7) * 0.1);
+        second[i] = (T) ((i % 5) * 0.2);
+    }
+    for(size_t i = 0; i < size; ++i)
+        vect[i] = vect_transposed[i] = (T) (i * 0.01);
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
+    std::chrono::duration<double> elapsed_time;
+
+// Matrix Matrix multiplication
+    start = std::chrono::high_resolution_clock::now();
+
+    Matrix<T> result = first * second;
+
+    end = std::chrono::high_resolution_clock::now();
+    elapsed_time = end-start;
+    std::cout << "Time for " << size << "x" << size << " " << type << " matrix matrix multiplication : " << elapsed_time.count() << " seconds, ";
+    std::cout << 2.0*size*size*size / elapsed_time.count() / 1e9 << " GFLOP/s" << std::endl;
+
+// Matrix Vector multiplication
+    start = std::chrono::high_resolution_clock::now();
+
+    result = first * vect;
+
+    end = std::chrono::high_resolution_clock::now();
+    elapsed_time = end-start;
+    std::cout << "Time for " << size << "x" << size << " " << type << " matrix vector multiplication : " << elapsed_time.count() << " seconds, ";
+    std::cout << 2.0*size*size / elapsed_time.count() / 1e9 << " GFLOP/s" << std::endl;
+
+// Vector Matrix multiplication
+    start = std::chrono::high_resolution_clock::now();
+
+    result = vect_transposed * first;
+
+    end = std::chrono::high_resolution_clock::now();
+    elapsed_time = end-start;
+    std::cout << "Time for " << size << "x" << size << " " << type << " vector matrix multiplication : " << elapsed_time.count() << " seconds, ";
+    std::cout << 2.0*size*size / elapsed_time.count() / 1e9 << " GFLOP/s" << std::endl;
+}
+
 template <class T>
 const Matrix<T> SquareMatrix()
 {
@@ -148,6 +199,23 @@ bool TransposeRect()
 template <>
 bool TransposeRect<std::complex<double>>();
 
+template <class T>
+bool TransposeInPlace()
+{
+    std::string type(typeid(T).name());
+    std::cout << "In-place transpose test with " << type << " large rect matrices: ";
+
+    Matrix<T> large(1501, 1001);
+    for(size_t i = 0; i < large.Length(); ++i)
+        large[i] = (T) i;
+    const Matrix<T> expected_result = large.Transpose();
+    std::move(large).Transpose();
+    bool test_result = large.Height() == 1001 && large.Width() == 1501 && (Compare(expected_result, large));
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 template <class T>
 bool Add()
 {
@@ -326,8 +394,43 @@ bool Shrink()
 template <>
 bool Shrink<std::complex<double>>();
 
+template <class T>
+bool Expression()
+{
+    std::string type(typeid(T).name());
+    std::cout << "Expression test with " << type << " : ";
+
+    const Matrix<T> square = SquareMatrix<T>();
+    T data[9] = {0,4,10,18,28,40,54,70,88};
+    const Matrix<T> expected_result(data, 9, 3, 3);
+    Matrix<T> result = Lazy(square) + (square & square) - (T)2 * square / square;
+    bool test_result = (Compare(expected_result, result));
+
+    result = Lazy(result) - square;
+    test_result &= IsEqual(Sum(Lazy(result) + square), (T) 312);
+    test_result &= IsEqual(Inner(Lazy(square), square), square.Norm(two_squared));
+    test_result &= IsEqual(Norm(Lazy(square) - result, one), (square - result).Norm(one));
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+template <>
+bool Expression<std::complex<double>>();
+
 bool Input();
 
+bool InputBinaryFile();
+
+bool View();
+
+bool Pool();
+
+bool Reduction();
+
+bool CCLarge();
+
+bool CholeskyTest();
+
 template <class T>
 bool CC()
 {
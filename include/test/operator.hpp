@@ -15,7 +15,9 @@
 #include "utils/linearop/operator/blurring.hpp"
 #include "utils/linearop/operator/convolution.hpp"
 #include "utils/linearop/operator/fourier.hpp"
+#include "utils/linearop/operator/hybridmatmult.hpp"
 #include "utils/linearop/operator/matmult/spline.hpp"
+#include "utils/linearop/operator/restrictedoperator.hpp"
 #include "utils/linearop/operator/wavelet.hpp"
 
 #include <chrono>
@@ -30,6 +32,7 @@ namespace oper
 {
 
 bool ConvolutionTest();
+bool ConvolutionTestInterior();
 void ConvolutionTime(size_t data_length, size_t filter_length);
 
 bool AbelTestBuild();
@@ -37,7 +40,9 @@ bool AbelTestApply();
 bool AbelTestApply2();
 bool AbelTestTransposed();
 bool AbelTestTransposed2();
-void AbelTime(size_t pic_size);
+bool AbelTestMultiple();
+bool AbelTestStorage();
+void AbelTime(size_t pic_size, AbelStorage storage = abel_full);
 
 bool WaveletTest();
 bool WaveletTest2();
@@ -46,12 +51,27 @@ bool WaveletTest3();
 bool SplineTest();
 
 bool BlurTest();
+bool BlurBackendTest();
+bool SeparableConvolutionTest();
+
+bool HybridTest();
 
 bool FourierTest();
+bool FourierTestDFT();
+bool FourierTestReal();
 
 bool AstroTest();
 bool AstroTestTransposed();
 
+bool RestrictedTest();
+
+bool ApplyTest();
+
+bool SharedStateTest();
+
+bool TransposeFlagTest();
+bool AbelSplineTest();
+
 } // namespace oper
 } // namespace test
 } // namespace alias
@@ -0,0 +1,63 @@
+///
+/// \file include/utils/bfloat16.hpp
+/// \brief Brain floating point header
+/// \details Provide a 16 bit storage type keeping the exponent range of single precision, used for tables read by bandwidth bound kernels.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_BFLOAT16_HPP
+#define ASTROQUT_UTILS_BFLOAT16_HPP
+
+#include "const.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace alias
+{
+
+/** Storage only floating point type
+ *  \brief Upper half of a single precision number, 8 bits of mantissa. Arithmetic is done after widening to float.
+ */
+struct Bfloat16
+{
+    uint16_t bits; //!< Member variable "bits" sign, exponent and mantissa of the upper half of a float
+
+    /** Default constructor
+     *  Uninitialized value, for bulk allocations
+     */
+    Bfloat16() = default;
+
+    /** Conversion constructor
+     *  \brief Rounds to the nearest value, ties to even, and keeps NaN a NaN
+     *  \param value Value to convert
+     */
+    explicit Bfloat16(float value) noexcept
+    {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        if( std::isnan(value) )
+            bits = (uint16_t)((word >> 16) | 0x0040);
+        else
+            bits = (uint16_t)((word + 0x7FFF + ((word >> 16) & 1)) >> 16);
+    }
+
+    /** Widening conversion
+     *  \return The exact single precision value
+     */
+    operator float() const noexcept
+    {
+        uint32_t word = (uint32_t) bits << 16;
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_BFLOAT16_HPP
@@ -0,0 +1,295 @@
+///
+/// \file include/utils/binaryfile.hpp
+/// \brief Binary matrix file header
+/// \details Provide the self-describing binary matrix format and read-only memory mappings of input files.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_BINARYFILE_HPP
+#define ASTROQUT_UTILS_BINARYFILE_HPP
+
+#include "const.hpp"
+
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __unix__
+
+namespace alias
+{
+namespace binaryfile
+{
+
+/** Element types of the binary format
+ */
+enum DType : uint32_t {unknown = 0, int8, uint8, int16, uint16, int32, uint32, int64, uint64, float32, float64, complex64, complex128};
+
+template <class T> struct DTypeOf { static constexpr DType value = unknown; };
+template <> struct DTypeOf<int8_t> { static constexpr DType value = int8; };
+template <> struct DTypeOf<uint8_t> { static constexpr DType value = uint8; };
+template <> struct DTypeOf<int16_t> { static constexpr DType value = int16; };
+template <> struct DTypeOf<uint16_t> { static constexpr DType value = uint16; };
+template <> struct DTypeOf<int32_t> { static constexpr DType value = int32; };
+template <> struct DTypeOf<uint32_t> { static constexpr DType value = uint32; };
+template <> struct DTypeOf<int64_t> { static constexpr DType value = int64; };
+template <> struct DTypeOf<uint64_t> { static constexpr DType value = uint64; };
+template <> struct DTypeOf<float> { static constexpr DType value = float32; };
+template <> struct DTypeOf<double> { static constexpr DType value = float64; };
+template <> struct DTypeOf<std::complex<float>> { static constexpr DType value = complex64; };
+template <> struct DTypeOf<std::complex<double>> { static constexpr DType value = complex128; };
+
+/** Size in bytes of one element
+ *  \param dtype Element type
+ *  \return The size, 0 if unknown
+ */
+inline size_t DTypeSize(DType dtype) noexcept
+{
+    switch(dtype)
+    {
+    case int8: case uint8: return 1;
+    case int16: case uint16: return 2;
+    case int32: case uint32: case float32: return 4;
+    case int64: case uint64: case float64: case complex64: return 8;
+    case complex128: return 16;
+    default: return 0;
+    }
+}
+
+inline constexpr char magic[8] = {'A','L','I','A','S','M','A','T'}; //!< First bytes of every file of the format
+inline constexpr uint32_t version = 1; //!< Current version of the format
+inline constexpr uint32_t endianness_marker = 0x01020304; //!< Written in native byte order, reads byte-swapped on a foreign machine
+inline constexpr size_t alignment = 64; //!< Alignment of the data section in the file
+
+/** File header, followed by the data at data_offset in row-major order
+ */
+struct Header
+{
+    char magic[8]; //!< Member variable "magic"
+    uint32_t version; //!< Member variable "version"
+    uint32_t dtype; //!< Member variable "dtype" one of DType
+    uint32_t endianness; //!< Member variable "endianness" endianness_marker as written by the producer
+    uint32_t alignment; //!< Member variable "alignment" alignment of data_offset
+    uint64_t height; //!< Member variable "height"
+    uint64_t width; //!< Member variable "width"
+    uint64_t data_offset; //!< Member variable "data_offset" position of the first element from the beginning of the file
+    uint8_t reserved[16]; //!< Member variable "reserved" zeros
+};
+static_assert(sizeof(Header) == 64, "Binary matrix header must be 64 bytes long");
+
+/** Byte swap of a 32 or 64 bits header field
+ */
+inline uint32_t ByteSwap(uint32_t value) noexcept
+{
+    return __builtin_bswap32(value);
+}
+inline uint64_t ByteSwap(uint64_t value) noexcept
+{
+    return __builtin_bswap64(value);
+}
+
+/** Byte swap of one element in place
+ *  \param element First byte of the element
+ *  \param dtype Type of the element, complex numbers are swapped part by part
+ */
+inline void ByteSwapElement(unsigned char* element, DType dtype) noexcept
+{
+    size_t part_size = (dtype == complex64 || dtype == complex128) ? DTypeSize(dtype)/2 : DTypeSize(dtype);
+    for(unsigned char* part = element; part < element + DTypeSize(dtype); part += part_size)
+        for(size_t i = 0; i < part_size/2; ++i)
+            std::swap(part[i], part[part_size-1-i]);
+}
+
+/** Header of the file if it uses the format
+ *  \param data First bytes of the file
+ *  \param size Size of the file
+ *  \param header Header with fields in native byte order
+ *  \param swap True if the file was written on a machine with the other endianness
+ *  \return True if the file uses the format, false if it is a raw headerless file
+ */
+inline bool ParseHeader(const void* data, size_t size, Header& header, bool& swap)
+{
+    if( size < sizeof(Header) || std::memcmp(data, magic, sizeof(magic)) != 0 )
+        return false;
+
+    std::memcpy(&header, data, sizeof(Header));
+    swap = header.endianness != endianness_marker;
+    if( swap )
+    {
+        if( ByteSwap(header.endianness) != endianness_marker )
+            throw std::invalid_argument("Binary matrix file has an invalid endianness marker!");
+        header.version = ByteSwap(header.version);
+        header.dtype = ByteSwap(header.dtype);
+        header.alignment = ByteSwap(header.alignment);
+        header.height = ByteSwap(header.height);
+        header.width = ByteSwap(header.width);
+        header.data_offset = ByteSwap(header.data_offset);
+    }
+    if( header.version > version )
+        throw std::invalid_argument("Binary matrix file version is not supported!");
+    if( DTypeSize((DType) header.dtype) == 0 )
+        throw std::invalid_argument("Binary matrix file has an unknown element type!");
+    if( header.data_offset < sizeof(Header) || header.data_offset + header.height*header.width*DTypeSize((DType) header.dtype) > size )
+        throw std::invalid_argument("Binary matrix file is truncated!");
+    return true;
+}
+
+/** Header describing a matrix of the given type and size
+ *  \param height Height of the matrix
+ *  \param width Width of the matrix
+ *  \return A header with the data right after it
+ */
+template <class T>
+Header MakeHeader(size_t height, size_t width) noexcept
+{
+    Header header {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.dtype = DTypeOf<T>::value;
+    header.endianness = endianness_marker;
+    header.alignment = alignment;
+    header.height = height;
+    header.width = width;
+    header.data_offset = sizeof(Header);
+    return header;
+}
+
+/** Read-only file mapping
+ *  \brief Pages are mapped private, writing to them triggers a copy and never touches the file
+ */
+class Mapping
+{
+private:
+    void* data_; //!< Member variable "data_" first byte of the file
+    size_t size_; //!< Member variable "size_" size of the file
+
+    /** Registry of the mappings handed over to Matrix instances, indexed by their data pointer
+     */
+    static std::unordered_map<const void*, Mapping>& Registry()
+    {
+        static std::unordered_map<const void*, Mapping> registry;
+        return registry;
+    }
+    static std::mutex& RegistryMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+public:
+    /** Default constructor
+     */
+    Mapping() noexcept
+        : data_(nullptr)
+        , size_(0)
+    {}
+
+    /** File constructor
+     *  \param filename Path of the file to map
+     */
+    explicit Mapping(const std::string& filename)
+        : Mapping()
+    {
+#ifdef DEBUG
+        std::cout << "Mapping : File constructor called with filename=" << filename << std::endl;
+#endif // DEBUG
+#ifdef __unix__
+        int file = open(filename.c_str(), O_RDONLY);
+        if( file < 0 )
+            throw std::invalid_argument("Could not open " + filename);
+        struct stat file_stat;
+        if( fstat(file, &file_stat) != 0 || file_stat.st_size == 0 )
+        {
+            close(file);
+            throw std::invalid_argument("Input file is empty or unreadable: " + filename);
+        }
+        size_ = file_stat.st_size;
+        data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        close(file);
+        if( data_ == MAP_FAILED )
+        {
+            data_ = nullptr;
+            throw std::invalid_argument("Could not map " + filename);
+        }
+        madvise(data_, size_, MADV_SEQUENTIAL);
+#else
+        std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
+        size_ = file.tellg();
+        if( !file || size_ == 0 )
+            throw std::invalid_argument("Input file is empty or unreadable: " + filename);
+        data_ = ::operator new(size_, std::align_val_t(alignment));
+        file.seekg(0, std::ios::beg);
+        file.read(static_cast<char*>(data_), size_);
+#endif // __unix__
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    Mapping(Mapping&& other) noexcept
+        : Mapping()
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    ~Mapping()
+    {
+        if( data_ != nullptr )
+        {
+#ifdef __unix__
+            munmap(data_, size_);
+#else
+            ::operator delete(data_, std::align_val_t(alignment));
+#endif // __unix__
+        }
+    }
+
+    unsigned char* Data() const noexcept
+    {
+        return static_cast<unsigned char*>(data_);
+    }
+    size_t Size() const noexcept
+    {
+        return size_;
+    }
+
+    /** Keep the mapping alive as long as a Matrix uses it
+     *  \param mapping Mapping to keep
+     *  \param user Pointer inside the mapping used as key
+     */
+    static void Keep(Mapping&& mapping, const void* user)
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        Registry().emplace(user, std::move(mapping));
+    }
+
+    /** Release a mapping kept for a Matrix
+     *  \param user Pointer given to Keep
+     */
+    static void Release(const void* user) noexcept
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        Registry().erase(user);
+    }
+};
+
+} // namespace binaryfile
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_BINARYFILE_HPP
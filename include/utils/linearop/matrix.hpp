@@ -11,7 +11,10 @@
 #ifndef ASTROQUT_UTILS_MATRIX_HPP
 #define ASTROQUT_UTILS_MATRIX_HPP
 
+#include "utils/binaryfile.hpp"
 #include "utils/linearop.hpp"
+#include "utils/memorypool.hpp"
+#include "utils/reduction.hpp"
 
 #include <algorithm>
 #include <cmath>
@@ -20,11 +23,12 @@
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <omp.h>
-#include <queue>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #ifdef __unix__
 #include <CCfits/CCfits>
@@ -40,6 +44,11 @@ template <class T> struct is_complex<std::complex<T>> : std::true_type {};
 template <class T> struct ExtractType;
 template <template <class ...> class Main, class Sub> struct ExtractType<Main<Sub>> { using SubType = Sub; };
 
+/** Type used to accumulate sums of T, single precision sums are accumulated in double precision
+ */
+template <class T> struct AccumulatorType { using type = T; };
+template <> struct AccumulatorType<float> { using type = double; };
+
 /** Types of norm currently implemented
  */
 enum NormType {one, two, two_squared, inf};
@@ -97,6 +106,11 @@ inline std::string str_tolower(std::string str)
     return str;
 }
 
+template <class E>
+class MatrixExpression;
+template <class T>
+class MatrixView;
+
 #ifdef VERBOSE
 template <class T>
 class Matrix;
@@ -108,7 +122,253 @@ template <class T = double>
 class Matrix : public LinearOp
 {
 private:
+    /** Origin of data_, defines how it is released
+     */
+    enum Storage {pooled,   //!< allocated from the MemoryPool
+                  adopted,  //!< allocated with new[] and handed over to this
+                  borrowed, //!< owned by someone else, see MatrixView::Borrow
+                  mapped    //!< private memory mapping of a binary file, see binaryfile::Mapping
+                 };
+
     T* data_; //!< Member variable "data_"
+    Storage storage_; //!< Member variable "storage_"
+
+    template <class U>
+    friend class MatrixView;
+
+    /** Borrowing constructor
+     *  \param data Data owned by someone else, must outlive this
+     *  \param height Height of the data
+     *  \param width Width of the data
+     *  \param storage Shall be borrowed
+     */
+    Matrix(T* data, size_t height, size_t width, Storage storage) noexcept
+        : LinearOp(height, width)
+        , data_(data)
+        , storage_(storage)
+    {
+#ifdef DEBUG
+        std::cout << "Matrix : Borrowing constructor called with data=" << data << ", height=" << height << ", width=" << width << std::endl;
+#endif // DEBUG
+    }
+
+    /** Allocate storage from the memory pool
+     *  \param length Amount of elements to allocate
+     *  \return A pointer to the value-initialized storage
+     */
+    static T* Allocate(size_t length)
+    {
+        T* data = static_cast<T*>(MemoryPool::Instance().Allocate(length * sizeof(T)));
+        if( !std::is_trivially_default_constructible<T>::value )
+            std::uninitialized_value_construct_n(data, length);
+        return data;
+    }
+
+    /** Release the storage held by data_
+     */
+    void Release() noexcept
+    {
+        if( storage_ == pooled )
+        {
+            if( !std::is_trivially_destructible<T>::value && data_ != nullptr )
+                std::destroy_n(data_, this->length_);
+            MemoryPool::Instance().Deallocate(data_);
+        }
+        else if( storage_ == adopted )
+            delete[] data_;
+        else if( storage_ == mapped )
+            binaryfile::Mapping::Release(data_);
+        data_ = nullptr;
+    }
+
+    /** Convert the elements of a file into data_
+     *  \param source First element in the file
+     *  \param swap True if the bytes of each element must be reversed
+     */
+    template <class U>
+    void ConvertFrom(const unsigned char* source, bool swap)
+    {
+        if constexpr( is_complex<U>::value && !is_complex<T>::value )
+        {
+            throw std::invalid_argument("Complex file data cannot be loaded into a real Matrix!");
+        }
+        else
+        {
+            if( swap )
+            {
+                #pragma omp parallel for
+                for(size_t i = 0; i < this->length_; ++i)
+                {
+                    U value;
+                    std::memcpy(&value, source + i*sizeof(U), sizeof(U));
+                    binaryfile::ByteSwapElement(reinterpret_cast<unsigned char*>(&value), binaryfile::DTypeOf<U>::value);
+                    data_[i] = (T) value;
+                }
+            }
+            else
+            {
+                const U* typed_source = reinterpret_cast<const U*>(source);
+                #pragma omp parallel for simd
+                for(size_t i = 0; i < this->length_; ++i)
+                    data_[i] = (T) typed_source[i];
+            }
+        }
+    }
+    void ConvertFrom(const unsigned char* source, binaryfile::DType dtype, bool swap)
+    {
+        switch(dtype)
+        {
+        case binaryfile::int8: ConvertFrom<int8_t>(source, swap); break;
+        case binaryfile::uint8: ConvertFrom<uint8_t>(source, swap); break;
+        case binaryfile::int16: ConvertFrom<int16_t>(source, swap); break;
+        case binaryfile::uint16: ConvertFrom<uint16_t>(source, swap); break;
+        case binaryfile::int32: ConvertFrom<int32_t>(source, swap); break;
+        case binaryfile::uint32: ConvertFrom<uint32_t>(source, swap); break;
+        case binaryfile::int64: ConvertFrom<int64_t>(source, swap); break;
+        case binaryfile::uint64: ConvertFrom<uint64_t>(source, swap); break;
+        case binaryfile::float32: ConvertFrom<float>(source, swap); break;
+        case binaryfile::float64: ConvertFrom<double>(source, swap); break;
+        case binaryfile::complex64: ConvertFrom<std::complex<float>>(source, swap); break;
+        case binaryfile::complex128: ConvertFrom<std::complex<double>>(source, swap); break;
+        default: throw std::invalid_argument("Unknown element type in binary file!");
+        }
+    }
+
+    /** Load a binary file
+     *  \brief The file is memory-mapped, its data is used in place if the element type matches T, converted in a single pass otherwise
+     *  \param filename Path of the file, either in the binaryfile format or raw headerless data
+     *  \param raw_dtype Element type of headerless files
+     */
+    void Load(const std::string& filename, binaryfile::DType raw_dtype)
+    {
+        binaryfile::Mapping mapping(filename);
+        binaryfile::Header header;
+        bool swap = false;
+        if( !binaryfile::ParseHeader(mapping.Data(), mapping.Size(), header, swap) )
+        {
+            if( binaryfile::DTypeSize(raw_dtype) == 0 )
+                throw std::invalid_argument("Unknown element type for headerless file " + filename);
+            header.dtype = raw_dtype;
+            header.height = mapping.Size() / binaryfile::DTypeSize(raw_dtype);
+            header.width = 1;
+            header.data_offset = 0;
+        }
+
+        this->height_ = header.height;
+        this->width_ = header.width;
+        this->length_ = this->height_ * this->width_;
+        const unsigned char* source = mapping.Data() + header.data_offset;
+
+        if( header.dtype == binaryfile::DTypeOf<T>::value && !swap && reinterpret_cast<size_t>(source) % alignof(T) == 0 )
+        {
+            data_ = reinterpret_cast<T*>(const_cast<unsigned char*>(source));
+            storage_ = mapped;
+            binaryfile::Mapping::Keep(std::move(mapping), data_);
+        }
+        else
+        {
+            data_ = Allocate(this->length_);
+            storage_ = pooled;
+            ConvertFrom(source, (binaryfile::DType) header.dtype, swap);
+        }
+    }
+
+    static constexpr size_t in_place_transpose_min_bytes = (size_t)1 << 23; //!< Rectangular matrices from this size on are transposed without a second buffer
+
+    /** Cache-oblivious transpose of a block
+     *  \brief Halves the largest dimension until the block fits in L1
+     *  \param source Top left element of the block to read
+     *  \param destination Top left element of the transposed block to write
+     *  \param rows Amount of rows of the source block
+     *  \param cols Amount of columns of the source block
+     *  \param source_width Row stride of the source
+     *  \param destination_width Row stride of the destination
+     */
+    static void TransposeBlock(const T* __restrict__ source, T* __restrict__ destination, size_t rows, size_t cols, size_t source_width, size_t destination_width) noexcept
+    {
+        if( rows <= 16 && cols <= 16 )
+        {
+            for( size_t j = 0; j < cols; ++j )
+            {
+                #pragma omp simd
+                for( size_t i = 0; i < rows; ++i )
+                    destination[j*destination_width + i] = source[i*source_width + j];
+            }
+        }
+        else if( rows >= cols )
+        {
+            size_t half = rows / 2;
+            TransposeBlock(source, destination, half, cols, source_width, destination_width);
+            TransposeBlock(source + half*source_width, destination + half, rows - half, cols, source_width, destination_width);
+        }
+        else
+        {
+            size_t half = cols / 2;
+            TransposeBlock(source, destination, rows, half, source_width, destination_width);
+            TransposeBlock(source + half, destination + half*destination_width, rows, cols - half, source_width, destination_width);
+        }
+    }
+
+    /** Tiled out-of-place transpose
+     *  \param source Matrix data of size height by width
+     *  \param destination Transposed data of size width by height
+     *  \param height Height of the source
+     *  \param width Width of the source
+     */
+    static void TransposeTiled(const T* source, T* destination, size_t height, size_t width) noexcept
+    {
+        constexpr size_t tile = 256;
+        #pragma omp parallel for collapse(2) schedule(static)
+        for( size_t i = 0; i < height; i += tile )
+            for( size_t j = 0; j < width; j += tile )
+                TransposeBlock(source + i*width + j, destination + j*height + i,
+                               std::min(tile, height - i), std::min(tile, width - j), width, height);
+    }
+
+    /** In-place transpose of a square matrix
+     *  \brief Swaps pairs of tiles symmetric with respect to the diagonal
+     */
+    void TransposeSquareInPlace() noexcept
+    {
+        constexpr size_t tile = 32;
+        const size_t size = this->height_;
+        #pragma omp parallel for schedule(dynamic)
+        for( size_t ti = 0; ti < size; ti += tile )
+        {
+            const size_t i_end = std::min(ti + tile, size);
+            for( size_t tj = ti; tj < size; tj += tile )
+            {
+                const size_t j_end = std::min(tj + tile, size);
+                for( size_t i = ti; i < i_end; ++i )
+                    for( size_t j = (ti == tj ? i+1 : tj); j < j_end; ++j )
+                        std::swap(data_[i*size + j], data_[j*size + i]);
+            }
+        }
+    }
+
+    /** In-place transpose of a rectangular matrix
+     *  \brief Follows the cycles of the permutation i -> i*height mod (length-1), a bitset marks the elements already moved
+     */
+    void TransposeCyclesInPlace()
+    {
+        const size_t last = this->length_ - 1;
+        std::vector<bool> moved(this->length_, false);
+        for( size_t start = 1; start < last; ++start )
+        {
+            if( moved[start] )
+                continue;
+
+            T value = data_[start];
+            size_t current = start;
+            do
+            {
+                current = (current * this->height_) % last;
+                std::swap(value, data_[current]);
+                moved[current] = true;
+            }
+            while( current != start );
+        }
+    }
 
 public:
     /** Default constructor
@@ -116,6 +376,7 @@ public:
      */
     Matrix() noexcept
         : data_(nullptr)
+        , storage_(pooled)
     {
 #ifdef DEBUG
         std::cout << "Matrix : Default constructor called" << std::endl;
@@ -130,23 +391,25 @@ public:
     Matrix(size_t height, size_t width)
         : LinearOp(height, width)
         , data_(nullptr)
+        , storage_(pooled)
     {
 #ifdef DEBUG
         std::cout << "Matrix : Empty constructor called with height=" << height << ", width=" << width << std::endl;
 #endif // DEBUG
 
         if(this->length_ != 0)
-            data_ = new T[this->length_];
+            data_ = Allocate(this->length_);
     }
 
     /** Full member constructor
-     *  \param data Dynamic 2D array containing the pixels
+     *  \param data Dynamic 2D array containing the pixels, allocated with new[] as ownership is taken
      *  \param height Height of the data
      *  \param width Width of the data
      */
     Matrix(T* data, size_t height, size_t width)
         : LinearOp(height, width)
         , data_(data)
+        , storage_(adopted)
     {
 #ifdef DEBUG
         std::cout << "Matrix : Full member constructor called with data=" << data << ", height=" << height << ", width=" << width << std::endl;
@@ -172,46 +435,34 @@ public:
     }
 
     /** File constructor with known size
-     *  \param filename Path of the binary file to read the matrix data from
+     *  \param filename Path of the binary file to read the matrix data from, either in the binaryfile format or raw headerless data of type U
      *  \param height Height of the data
      *  \param width Width of the data
      */
     template <class U = T, typename std::enable_if_t<std::is_arithmetic<U>::value>* = nullptr>
     Matrix(const std::string filename, size_t height, size_t width, U __attribute__((unused)) dummy = 0)
-        : Matrix(height, width)
+        : Matrix()
     {
 #ifdef DEBUG
         std::cout << "Matrix : File constructor with known size called with filename=" << filename << ", height=" << height << ", width=" << width << std::endl;
 #endif // DEBUG
 
-        std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
-
-        size_t file_size = file.tellg();
-        if(file_size == 0)
-        {
-            std::cerr << "Input file is empty";
-            throw;
-        }
-        char* memblock = new char [file_size];
-        file.seekg(0, std::ios::beg);
-        file.read(memblock, file_size);
-        file.close();
-
-        U* reinterpret_memblock = (U*) memblock;
-
-        #pragma omp parallel for simd
-        for(size_t i = 0; i < this->length_; ++i)
-            data_[i] = reinterpret_memblock[i];
+        Load(filename, binaryfile::DTypeOf<U>::value);
+        if( this->length_ < height * width )
+            throw std::invalid_argument("Input file " + filename + " is too small for the requested dimensions!");
 
-        delete[] memblock;
+        this->height_ = height;
+        this->width_ = width;
+        this->length_ = height * width;
     }
 
     /** File constructor raw
-     *  \param filename Path of the binary file to read the matrix data from
+     *  \param filename Path of the binary file to read the matrix data from, FITS, binaryfile format or raw headerless data of type U
      */
     template <class U = T, typename std::enable_if_t<std::is_arithmetic<U>::value>* = nullptr>
     Matrix(const std::string filename, U __attribute__((unused)) dummy = 0)
         : data_(nullptr)
+        , storage_(pooled)
     {
 #ifdef DEBUG
         std::cout << "Matrix : File constructor raw called with filename=" << filename << std::endl;
@@ -229,7 +480,7 @@ public:
             width_ = 1;
             length_ = height_;
 
-            data_ = new T[length_];
+            data_ = Allocate(length_);
 
             #pragma omp parallel for simd
             for(size_t i = 0; i < length_; ++i)
@@ -238,34 +489,7 @@ public:
         else
 #endif // __unix__
         {
-            std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
-
-            size_t file_size = file.tellg();
-            if(file_size == 0)
-            {
-                std::cerr << "Input file is empty";
-                throw;
-            }
-            char* memblock = new char[file_size];
-            file.seekg(0, std::ios::beg);
-            file.read(memblock, file_size);
-            file.close();
-
-            U* reinterpret_memblock = (U*) memblock;
-
-            size_t length = file_size / sizeof(U);
-
-            data_ = new T[length];
-
-            height_ = length;
-            width_ = 1;
-            length_ = height_;
-
-            #pragma omp parallel for simd
-            for(size_t i = 0; i < length_; ++i)
-                data_[i] = reinterpret_memblock[i];
-
-            delete[] memblock;
+            Load(filename, binaryfile::DTypeOf<U>::value);
         }
     }
 
@@ -287,6 +511,24 @@ public:
             data_[i] = (T) number;
     }
 
+    /** Expression constructor
+     *  \brief Evaluates a lazy element-wise expression in a single pass, see utils/linearop/matrix/expression.hpp
+     *  \param expression Expression to evaluate
+     */
+    template <class E>
+    Matrix(const MatrixExpression<E>& expression)
+        : Matrix(expression.Height(), expression.Width())
+    {
+#ifdef DEBUG
+        std::cout << "Matrix : Expression constructor called" << std::endl;
+#endif // DEBUG
+
+        const E& expr = expression.Self();
+        #pragma omp parallel for simd
+        for(size_t i = 0; i < this->length_; ++i)
+            data_[i] = expr[i];
+    }
+
     /** Copy constructor
      *  \param other Object to copy from
      */
@@ -305,6 +547,27 @@ public:
         }
     }
 
+    /** Conversion constructor
+     *  \brief Copy of a Matrix of another arithmetic type, e.g. to switch between single and double precision
+     *  \param other Object to convert from
+     */
+    template <class U, typename std::enable_if_t<!std::is_same<U, T>::value && std::is_arithmetic<U>::value && std::is_arithmetic<T>::value>* = nullptr>
+    explicit Matrix(const Matrix<U>& other)
+        : Matrix(other.Height(), other.Width())
+    {
+#ifdef DEBUG
+        std::cout << "Matrix : Conversion constructor called" << std::endl;
+#endif // DEBUG
+
+        const U* other_data = other.Data();
+        if( other_data != nullptr )
+        {
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < this->length_; ++i)
+                data_[i] = (T) other_data[i];
+        }
+    }
+
     /** Move constructor
      *  \param other Object to move from
      */
@@ -332,8 +595,7 @@ public:
 #ifdef DEBUG
         std::cout << "Matrix : Destructor called" << std::endl;
 #endif // DEBUG
-        delete[] data_;
-        data_ = nullptr;
+        Release();
     }
 
     /** Access data_
@@ -344,11 +606,12 @@ public:
         return data_;
     }
     /** Set data_
-     * \param data New value to set
+     * \param data New value to set, ownership is taken as for the full member constructor
      */
     void Data(T* const data)
     {
         data_ = data;
+        storage_ = adopted;
     }
 
     /** Empty test operator
@@ -434,6 +697,7 @@ public:
 
         swap(static_cast<LinearOp&>(first), static_cast<LinearOp&>(second));
         swap(first.data_, second.data_);
+        swap(first.storage_, second.storage_);
     }
 
     /** Copy assignment operator
@@ -449,6 +713,33 @@ public:
         return *this;
     }
 
+    /** Expression assignment operator
+     *  \brief Evaluates the expression in place if the size matches, element-wise expressions may refer to this
+     *  \param expression Expression to evaluate
+     *  \return A reference to this
+     */
+    template <class E>
+    Matrix& operator=(const MatrixExpression<E>& expression)
+    {
+#ifdef DEBUG
+        std::cout << "Matrix : Expression assignment operator called" << std::endl;
+#endif // DEBUG
+        if( data_ == nullptr || this->length_ != expression.Length() )
+        {
+            Matrix result(expression);
+            swap(*this, result);
+            return *this;
+        }
+
+        this->height_ = expression.Height();
+        this->width_ = expression.Width();
+        const E& expr = expression.Self();
+        #pragma omp parallel for simd
+        for(size_t i = 0; i < this->length_; ++i)
+            data_[i] = expr[i];
+        return *this;
+    }
+
     /** Cast operator
      *  \return A casted copy of this
      */
@@ -818,18 +1109,14 @@ public:
         // matrix
         else
         {
-            #pragma omp parallel for
-            for ( size_t i = 0; i < this->height_; ++i )
-            {
-                #pragma omp simd
-                for ( size_t j = 0 ; j < this->width_; ++j )
-                    result.data_[ j * this->height_ + i ] = data_[ i * this->width_ + j ];
-            }
+            TransposeTiled(data_, result.data_, this->height_, this->width_);
         }
         return result;
     }
 
     /** Transpose in-place
+    *   \brief Small rectangular matrices go through a pooled buffer, large ones are permuted in place with
+    *   only one bit of extra memory per element
     *   \return A reference to this
     */
     Matrix&& Transpose() &&
@@ -853,36 +1140,25 @@ public:
         // matrix
         else
         {
-            // square matrix, simple swap
+            // square matrix, swap tiles
             if( this->height_ == this->width_ )
             {
-
-                #pragma omp parallel for
-                for ( size_t i = 0; i < this->height_; ++i )
-                {
-                    #pragma omp simd
-                    for ( size_t j = i+1 ; j < this->width_; ++j )
-                        std::swap(data_[i * this->width_ + j], data_[j * this->width_ + i]);
-                }
-                std::swap(this->height_, this->width_); // width <--> height
+                TransposeSquareInPlace();
             }
-
-            // rect matrix, cyclic permutations
-            // TODO in-place algorithm
-            // for now, simple copy to new array
-            else
+            // small rect matrix, tiled copy to a recycled buffer
+            else if( this->length_ * sizeof(T) < in_place_transpose_min_bytes )
             {
                 Matrix result(this->width_, this->height_); // width <--> height
-
-                #pragma omp parallel for
-                for ( size_t i = 0; i < this->height_; ++i )
-                {
-                    #pragma omp simd
-                    for ( size_t j = 0 ; j < this->width_; ++j )
-                        result.data_[ j * this->height_ + i ] = data_[ i * this->width_ + j ];
-                }
-                *this = std::move(result);
+                TransposeTiled(data_, result.data_, this->height_, this->width_);
+                swap(*this, result);
+                return std::move(*this);
             }
+            // large rect matrix, cyclic permutations
+            else
+            {
+                TransposeCyclesInPlace();
+            }
+            std::swap(this->height_, this->width_); // width <--> height
         }
         return std::move(*this);
     }
@@ -1045,6 +1321,9 @@ public:
 
     /** Connected components
      *   Returns a matrix with connected components reduced to the single maximum element or every connected component
+     *   \brief Two pass union-find labelling of the 8-connected non-zero elements. Strips of rows are labelled in parallel,
+     *   then the strips are merged along their borders. Every root keeps the index of the maximum of its component
+     *   while unions happen, ties go to the lowest index.
      *   \return A new instance containing the result
      */
     Matrix ConnectedComponentsMax() const &
@@ -1052,76 +1331,94 @@ public:
 #ifdef VERBOSE
         std::cout << *this;
 #endif // VERBOSE
-        size_t CC_total = 0;
-        Matrix<T> CC_max(0.0, height_, width_);
-        Matrix<bool> CC_marked(false, height_, width_);
+        const size_t background = this->length_;
+        std::vector<size_t> parent(this->length_); // union-find forest over the element indices, roots are the lowest index of their tree
+        std::vector<size_t> max_index(this->length_); // index of the component maximum, valid for roots
 
-        for(size_t row = 0; row < height_; ++row)
+        // best of two candidate maxima
+        auto best = [this](size_t first, size_t second)
         {
-            for(size_t col = 0; col < width_; ++col)
+            if( IsSmaller(data_[first], data_[second]) || (!IsSmaller(data_[second], data_[first]) && second < first) )
+                return second;
+            return first;
+        };
+        auto find = [&parent](size_t index)
+        {
+            while( parent[index] != index )
             {
-                // consider only non-zero data and point not already marked
-                if( ! IsEqual(data_[row*width_ + col], (T) 0.0) && ! CC_marked[row*width_ + col])
+                parent[index] = parent[parent[index]]; // path halving
+                index = parent[index];
+            }
+            return index;
+        };
+        auto unite = [&](size_t first, size_t second)
+        {
+            size_t first_root = find(first);
+            size_t second_root = find(second);
+            if( first_root == second_root )
+                return;
+            if( second_root < first_root )
+                std::swap(first_root, second_root);
+            parent[second_root] = first_root;
+            max_index[first_root] = best(max_index[first_root], max_index[second_root]);
+        };
+        // join an element with its already visited neighbours of the row above, rows before first_row excluded
+        auto unite_above = [&](size_t row, size_t col, size_t first_row)
+        {
+            if( row == first_row )
+                return;
+            for(size_t neighbor_col = (col == 0 ? 0 : col-1); neighbor_col < std::min(col+2, width_); ++neighbor_col)
+                if( parent[(row-1)*width_ + neighbor_col] != background )
+                    unite((row-1)*width_ + neighbor_col, row*width_ + col);
+        };
+
+        // first pass, label every strip independently
+        const size_t strip_height = 64;
+        const size_t strips = (height_ + strip_height - 1) / strip_height;
+        #pragma omp parallel for schedule(dynamic)
+        for(size_t strip = 0; strip < strips; ++strip)
+        {
+            size_t first_row = strip * strip_height;
+            size_t last_row = std::min(first_row + strip_height, height_);
+            for(size_t row = first_row; row < last_row; ++row)
+            {
+                for(size_t col = 0; col < width_; ++col)
                 {
-                    // this is a new connected component
-                    ++CC_total;
-
-                    // mark current point
-                    CC_marked[row*width_ + col] = true;
-
-                    // initialise the new CC with the current non-zero point
-                    std::vector<size_t> CC_current = {row*width_ + col};
-                    std::queue<std::pair<int, int>> points;
-                    points.push(std::pair<int, int>(row, col));
-#ifdef VERBOSE
-                    std::cout << "(" << row << "," << col << ") <=> " << row*width_ + col << std::endl;
-#endif // VERBOSE
-
-                    // Breadth First Search to look for all points connected to the currentCC.
-                    while( ! points.empty() )
+                    size_t index = row*width_ + col;
+                    // consider only non-zero data
+                    if( IsEqual(data_[index], (T) 0.0) )
                     {
-                        std::pair<int, int> point = points.front();
-                        points.pop();
-                        // check all 8 neighbours of the current point
-                        for(int neighbor_row = std::max(point.first-1, 0); neighbor_row < std::min(point.first+2, (int)width_); ++neighbor_row )
-                        {
-                            for(int neighbor_col = std::max(point.second-1, 0); neighbor_col < std::min(point.second+2, (int)height_); ++neighbor_col )
-                            {
-                                size_t point_index = neighbor_row*width_ + neighbor_col;
-                                // do not check if it is already marked
-                                if(! CC_marked[point_index])
-                                {
-                                    CC_marked[point_index] = true;
-                                    // consider only if non zero
-                                    if( ! IsEqual( data_[point_index], (T) 0.0) )
-                                    {
-                                        CC_current.push_back(point_index);
-                                        points.push(std::pair<int, int>(neighbor_row, neighbor_col));
-#ifdef VERBOSE
-                                        std::cout << "(" << neighbor_row << "," << neighbor_col << ") <=> " << neighbor_row*width_ + neighbor_col << std::endl;
-#endif // VERBOSE
-                                    }
-                                }
-                            }
-                        }
+                        parent[index] = background;
+                        continue;
                     }
+                    parent[index] = index;
+                    max_index[index] = index;
+                    if( col != 0 && parent[index-1] != background )
+                        unite(index-1, index);
+                    unite_above(row, col, first_row);
+                }
+            }
+        }
 
-                    // get maximum value of the connected component
-                    size_t max_index = CC_current[0];
-                    for(size_t i = 1; i < CC_current.size(); ++i)
-                        if(IsSmaller(data_[max_index], data_[CC_current[i]]))
-                            max_index = CC_current[i];
-#ifdef VERBOSE
-                    std::cout << "Max index: " << max_index << std::endl;
-#endif // VERBOSE
-
-                    // assign the maximum value to its index in the result
-                    CC_max[max_index] = data_[max_index];
+        // second pass, merge the strips along their borders
+        for(size_t strip = 1; strip < strips; ++strip)
+        {
+            size_t row = strip * strip_height;
+            for(size_t col = 0; col < width_; ++col)
+                if( parent[row*width_ + col] != background )
+                    unite_above(row, col, 0);
+        }
 
-#ifdef VERBOSE
-                    std::cout << CC_max;
-#endif // VERBOSE
-                }
+        // keep the maximum of every component
+        Matrix<T> CC_max(0.0, height_, width_);
+        size_t CC_total = 0;
+        #pragma omp parallel for reduction(+:CC_total)
+        for(size_t i = 0; i < this->length_; ++i)
+        {
+            if( parent[i] == i )
+            {
+                ++CC_total;
+                CC_max[max_index[i]] = data_[max_index[i]];
             }
         }
 
@@ -1239,15 +1536,12 @@ public:
         }
 #endif // DO_ARGCHECKS
 
+        const T* data = data_;
         switch(l_norm)
         {
         case one:
         {
-            double result = 0.0;
-            #pragma omp parallel for reduction(+:result)
-            for(size_t i = 0; i < this->length_; ++i)
-                result += std::abs(data_[i]);
-            return result;
+            return reduction::Sum<double>(this->length_, [data](size_t i){ return (double) std::abs(data[i]); });
         }
         case two:
         {
@@ -1255,19 +1549,11 @@ public:
         }
         case two_squared:
         {
-            double result = 0.0;
-            #pragma omp parallel for reduction(+:result)
-            for(size_t i = 0; i < this->length_; ++i)
-                result += std::norm(data_[i]);
-            return result;
+            return reduction::Sum<double>(this->length_, [data](size_t i){ return (double) std::norm(data[i]); });
         }
         case inf:
         {
-            double result = 0.0;
-            #pragma omp parallel for reduction(max:result)
-            for(size_t i = 0; i < this->length_; ++i)
-                result = std::max(result, std::abs(data_[i]));
-            return result;
+            return reduction::Max<double>(this->length_, [data](size_t i){ return (double) std::abs(data[i]); });
         }
         default:
         {
@@ -1294,11 +1580,8 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        T result = 0;
-        #pragma omp parallel for reduction(+:result)
-        for(size_t i = 0; i < this->length_; ++i)
-            result += data_[i];
-        return result;
+        const T* data = data_;
+        return (T) reduction::Sum<typename AccumulatorType<T>::type>(this->length_, [data](size_t i){ return data[i]; });
     }
     template <class U = T, typename std::enable_if_t<is_complex<U> {}>* = nullptr, class ComplexSubType = typename ExtractType<U>::SubType>
     T Sum() const
@@ -1314,15 +1597,8 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        double result_real = 0;
-        double result_imag = 0;
-        #pragma omp parallel for reduction(+:result_real, result_imag)
-        for(size_t i = 0; i < this->length_; ++i)
-        {
-            result_real += data_[i].real();
-            result_imag += data_[i].imag();
-        }
-        return std::complex<ComplexSubType>(result_real, result_imag);
+        const T* data = data_;
+        return std::complex<ComplexSubType>(reduction::Sum<std::complex<double>>(this->length_, [data](size_t i){ return std::complex<double>(data[i]); }));
     }
 
     /** Min
@@ -1342,12 +1618,8 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        T result = std::numeric_limits<T>::infinity();
-        #pragma omp parallel for reduction(min:result)
-        for(size_t i = 0; i < this->length_; ++i)
-            result = std::min(result, data_[i]);
-        return result;
-
+        const T* data = data_;
+        return reduction::Min<T>(this->length_, [data](size_t i){ return data[i]; });
     }
 
     /** Max
@@ -1367,11 +1639,30 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        T result = -std::numeric_limits<T>::infinity();
-        #pragma omp parallel for reduction(max:result)
-        for(size_t i = 0; i < this->length_; ++i)
-            result = std::max(result, data_[i]);
-        return result;
+        const T* data = data_;
+        return reduction::Max<T>(this->length_, [data](size_t i){ return data[i]; });
+    }
+
+    /** Summary
+     *  Sum, one norm, squared two norm, min and max of all elements in a single sweep, considered as a one dimensional vector
+     *  \return The results of type double
+     */
+    template <class U = T, typename std::enable_if_t<std::is_arithmetic<U>::value>* = nullptr>
+    reduction::Summary Summarize() const
+    {
+#ifdef DO_ARGCHECKS
+        try
+        {
+            IsValid();
+        }
+        catch (const std::exception&)
+        {
+            throw;
+        }
+#endif // DO_ARGCHECKS
+
+        const T* data = data_;
+        return reduction::Summarize(this->length_, [data](size_t i){ return (double) data[i]; });
     }
 
     void PrintRefQual() const &
@@ -1763,15 +2054,15 @@ void operator<<(std::string filename, const Matrix<T>& mat)
     {
         std::ofstream file(filename, std::ios::binary | std::ios::out);
 
-        T* memblock = new T[mat.Length()];
-        #pragma omp parallel for simd
-        for(size_t i = 0; i < mat.Length(); ++i)
-            memblock[i] = mat[i];
-        char* reinterpret_memblock = (char*) memblock;
-        file.write(reinterpret_memblock, mat.Length()*sizeof(T));
+        // self-describing format, raw headerless data otherwise
+        if( str_tolower(filename.substr(filename.find_last_of('.') == std::string::npos ? filename.size() : filename.find_last_of('.'))) == ".alias" )
+        {
+            binaryfile::Header header = binaryfile::MakeHeader<T>(mat.Height(), mat.Width());
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        file.write(reinterpret_cast<const char*>(mat.Data()), mat.Length()*sizeof(T));
 
         file.close();
-        delete[] memblock;
     }
 }
 
@@ -1795,11 +2086,9 @@ T Inner(const Matrix<T>& first, const Matrix<T>& second)
     }
 #endif // DO_ARGCHECKS
 
-    T result = 0;
-    #pragma omp parallel for reduction(+:result)
-    for(size_t i = 0; i < first.Length(); ++i)
-        result += first[i] * second[i];
-    return result;
+    const T* first_data = first.Data();
+    const T* second_data = second.Data();
+    return (T) reduction::Sum<typename AccumulatorType<T>::type>(first.Length(), [first_data, second_data](size_t i){ return first_data[i] * second_data[i]; });
 }
 inline std::complex<double> Inner(const Matrix<std::complex<double>>& first, const Matrix<std::complex<double>>& second)
 {
@@ -1814,20 +2103,142 @@ inline std::complex<double> Inner(const Matrix<std::complex<double>>& first, con
     }
 #endif // DO_ARGCHECKS
 
-    double result_real = 0;
-    double result_imag = 0;
-    #pragma omp parallel for reduction(+:result_real, result_imag)
-    for(size_t i = 0; i < first.Length(); ++i)
+    const std::complex<double>* first_data = first.Data();
+    const std::complex<double>* second_data = second.Data();
+    return reduction::Sum<std::complex<double>>(first.Length(), [first_data, second_data](size_t i){ return std::conj(first_data[i]) * second_data[i]; });
+}
+
+/** Blocking parameters of the matrix multiplication kernels
+ *  \brief The micro-tile of mr rows by nr columns is kept in registers, a kc by nr sliver of the packed right
+ *  operand stays in L1, the mc by kc packed block of the left operand in L2 and the kc by nc packed right operand in L3.
+ */
+template <class T>
+struct MultBlocking
+{
+#if defined(__AVX512F__)
+    static constexpr size_t simd_bytes = 64;
+#elif defined(__AVX__)
+    static constexpr size_t simd_bytes = 32;
+#else
+    static constexpr size_t simd_bytes = 16;
+#endif // __AVX512F__
+    static constexpr size_t lanes = simd_bytes / sizeof(T) > 0 ? simd_bytes / sizeof(T) : 1;
+    static constexpr size_t mr = 6;
+    static constexpr size_t nr = 2 * lanes;
+    static constexpr size_t kc = 256;
+    static constexpr size_t mc = 16 * mr;
+    static constexpr size_t nc = 4096 / nr * nr;
+};
+
+/** Pack a block of the left operand of a matrix multiplication
+ *  \brief Stores the block as consecutive panels of mr rows, column-major inside a panel, padded with zeros
+ *  \param first Left operand
+ *  \param row_start First row of the block
+ *  \param rows Amount of rows of the block
+ *  \param col_start First column of the block
+ *  \param cols Amount of columns of the block
+ *  \param packed Destination buffer of at least ceil(rows/mr)*mr*cols elements
+ */
+template <class T>
+static inline void PackLeft(const Matrix<T>& first, size_t row_start, size_t rows, size_t col_start, size_t cols, T* packed)
+{
+    constexpr size_t mr = MultBlocking<T>::mr;
+    const size_t width = first.Width();
+    const T* data = first.Data();
+    for(size_t ir = 0; ir < rows; ir += mr)
+    {
+        const size_t panel_rows = std::min(mr, rows - ir);
+        T* panel = packed + ir * cols;
+        for(size_t p = 0; p < cols; ++p)
+        {
+            for(size_t i = 0; i < panel_rows; ++i)
+                panel[p*mr + i] = data[(row_start+ir+i)*width + col_start + p];
+            for(size_t i = panel_rows; i < mr; ++i)
+                panel[p*mr + i] = (T)0;
+        }
+    }
+}
+
+/** Pack a block of the right operand of a matrix multiplication
+ *  \brief Stores the block as consecutive panels of nr columns, row-major inside a panel, padded with zeros
+ *  \param second Right operand
+ *  \param row_start First row of the block
+ *  \param rows Amount of rows of the block
+ *  \param col_start First column of the block
+ *  \param cols Amount of columns of the block
+ *  \param packed Destination buffer of at least rows*ceil(cols/nr)*nr elements
+ */
+template <class T>
+static inline void PackRight(const Matrix<T>& second, size_t row_start, size_t rows, size_t col_start, size_t cols, T* packed)
+{
+    constexpr size_t nr = MultBlocking<T>::nr;
+    const size_t width = second.Width();
+    const T* data = second.Data();
+    #pragma omp parallel for
+    for(size_t jr = 0; jr < cols; jr += nr)
     {
-        std::complex<double> local_result = std::conj(first[i]) * second[i];
-        result_real += local_result.real();
-        result_imag += local_result.imag();
+        const size_t panel_cols = std::min(nr, cols - jr);
+        T* panel = packed + jr * rows;
+        for(size_t p = 0; p < rows; ++p)
+        {
+            const T* row = data + (row_start+p)*width + col_start + jr;
+            for(size_t j = 0; j < panel_cols; ++j)
+                panel[p*nr + j] = row[j];
+            for(size_t j = panel_cols; j < nr; ++j)
+                panel[p*nr + j] = (T)0;
+        }
+    }
+}
+
+/** Register-tiled micro-kernel
+ *  \brief Accumulates the product of an mr by depth panel and a depth by nr panel, then adds it to the result tile
+ *  \param depth Amount of columns of the left panel
+ *  \param left Packed left panel
+ *  \param right Packed right panel
+ *  \param result Top left element of the result tile
+ *  \param result_width Width of the result matrix
+ *  \param rows Amount of valid rows of the tile
+ *  \param cols Amount of valid columns of the tile
+ */
+template <class T>
+static inline void MultMicroKernel(size_t depth, const T* __restrict__ left, const T* __restrict__ right, T* __restrict__ result, size_t result_width, size_t rows, size_t cols)
+{
+    constexpr size_t mr = MultBlocking<T>::mr;
+    constexpr size_t nr = MultBlocking<T>::nr;
+    T acc[mr][nr] = {};
+
+    for(size_t p = 0; p < depth; ++p)
+    {
+        const T* a = left + p*mr;
+        const T* b = right + p*nr;
+        for(size_t i = 0; i < mr; ++i)
+        {
+            #pragma omp simd
+            for(size_t j = 0; j < nr; ++j)
+                acc[i][j] += a[i] * b[j];
+        }
+    }
+
+    if( rows == mr && cols == nr )
+    {
+        for(size_t i = 0; i < mr; ++i)
+        {
+            #pragma omp simd
+            for(size_t j = 0; j < nr; ++j)
+                result[i*result_width + j] += acc[i][j];
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < rows; ++i)
+            for(size_t j = 0; j < cols; ++j)
+                result[i*result_width + j] += acc[i][j];
     }
-    return std::complex<double>(result_real, result_imag);
 }
 
 /** Matrix Matrix multiplication
  *  Performs a matrix-matrix multiplication : result = first * second
+ *  \brief Cache-blocked on packed operands, every column of second is a right hand side
  *  \param first First matrix of size l by m
  *  \param second Second matrix of size m by n
  *  \param result Resulting matrix of size l by n
@@ -1835,38 +2246,122 @@ inline std::complex<double> Inner(const Matrix<std::complex<double>>& first, con
 template <class T>
 static inline void MatrixMatrixMult(const Matrix<T>& first, const Matrix<T>& second, Matrix<T>& result)
 {
+    using Blocking = MultBlocking<T>;
+    const size_t height = first.Height();
+    const size_t depth = first.Width();
+    const size_t width = second.Width();
+
     // Init result to zero
     #pragma omp parallel for simd
     for(size_t i = 0; i < result.Length(); ++i)
         result[i] = 0;
-    #pragma omp parallel for
-    for(size_t i = 0; i < first.Height(); ++i)
-        for(size_t k = 0; k < first.Width(); ++k)
-            for(size_t j = 0; j < second.Width(); ++j)
-                result[i*second.Width() + j] += first[i*first.Width() + k] * second[k*second.Width() + j];
+
+    const size_t packed_right_cols = (std::min(Blocking::nc, width) + Blocking::nr - 1) / Blocking::nr * Blocking::nr;
+    Matrix<T> packed_right(std::min(Blocking::kc, depth) * packed_right_cols, 1);
+
+    for(size_t jc = 0; jc < width; jc += Blocking::nc)
+    {
+        const size_t nc = std::min(Blocking::nc, width - jc);
+        for(size_t pc = 0; pc < depth; pc += Blocking::kc)
+        {
+            const size_t kc = std::min(Blocking::kc, depth - pc);
+            PackRight(second, pc, kc, jc, nc, packed_right.Data());
+
+            #pragma omp parallel
+            {
+                Matrix<T> packed_left(Blocking::mc * kc, 1);
+
+                #pragma omp for schedule(dynamic)
+                for(size_t ic = 0; ic < height; ic += Blocking::mc)
+                {
+                    const size_t mc = std::min(Blocking::mc, height - ic);
+                    PackLeft(first, ic, mc, pc, kc, packed_left.Data());
+
+                    for(size_t jr = 0; jr < nc; jr += Blocking::nr)
+                        for(size_t ir = 0; ir < mc; ir += Blocking::mr)
+                            MultMicroKernel(kc,
+                                            packed_left.Data() + ir*kc,
+                                            packed_right.Data() + jr*kc,
+                                            result.Data() + (ic+ir)*width + jc + jr,
+                                            width,
+                                            std::min(Blocking::mr, mc - ir),
+                                            std::min(Blocking::nr, nc - jr));
+                }
+            }
+        }
+    }
 }
 
 /** Matrix Vector multiplication
  *  Performs a matrix-vector multiplication : result = mat * vect
+ *  \brief Four rows are processed at once so that each element of vect is loaded once for four independent accumulators
  *  \param mat Matrix of size m by n
  *  \param vect Vector of size n by 1
  *  \param result Resulting vector of size m by 1
- *  \param type Computation strategy to use
  */
 template <class T>
 static inline void MatrixVectorMult(const Matrix<T>& mat, const Matrix<T>& vect, Matrix<T>& result)
 {
-    #pragma omp parallel for
-    for(size_t i = 0; i < mat.Height(); ++i)
+    const size_t height = mat.Height();
+    const size_t width = mat.Width();
+    const T* data = mat.Data();
+    const T* v = vect.Data();
+
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < height; i += 4)
     {
-        result[i] = (T)0;
-        for(size_t j = 0; j < mat.Width(); ++j)
-            result[i] += mat[i*mat.Width() + j] * vect[j];
+        if( i + 4 <= height )
+        {
+            const T* row_0 = data + i*width;
+            const T* row_1 = row_0 + width;
+            const T* row_2 = row_1 + width;
+            const T* row_3 = row_2 + width;
+            T sum_0 = (T)0;
+            T sum_1 = (T)0;
+            T sum_2 = (T)0;
+            T sum_3 = (T)0;
+            if constexpr( std::is_arithmetic<T>::value )
+            {
+                #pragma omp simd reduction(+:sum_0, sum_1, sum_2, sum_3)
+                for(size_t j = 0; j < width; ++j)
+                {
+                    sum_0 += row_0[j] * v[j];
+                    sum_1 += row_1[j] * v[j];
+                    sum_2 += row_2[j] * v[j];
+                    sum_3 += row_3[j] * v[j];
+                }
+            }
+            else
+            {
+                for(size_t j = 0; j < width; ++j)
+                {
+                    sum_0 += row_0[j] * v[j];
+                    sum_1 += row_1[j] * v[j];
+                    sum_2 += row_2[j] * v[j];
+                    sum_3 += row_3[j] * v[j];
+                }
+            }
+            result[i] = sum_0;
+            result[i+1] = sum_1;
+            result[i+2] = sum_2;
+            result[i+3] = sum_3;
+        }
+        else
+        {
+            for(size_t row = i; row < height; ++row)
+            {
+                T sum = (T)0;
+                for(size_t j = 0; j < width; ++j)
+                    sum += data[row*width + j] * v[j];
+                result[row] = sum;
+            }
+        }
     }
 }
 
 /** Vector Matrix multiplication
  *  Performs a matrix-vector multiplication : result = vect * mat
+ *  \brief Each thread owns a block of columns of the result, the rows of mat are streamed through it
  *  \param vect Vector of size 1 by m
  *  \param mat Matrix of size m by n
  *  \param result Resulting vector of size 1 by n
@@ -1874,14 +2369,28 @@ static inline void MatrixVectorMult(const Matrix<T>& mat, const Matrix<T>& vect,
 template <class T>
 static inline void VectorMatrixMult(const Matrix<T>& vect, const Matrix<T>& mat, Matrix<T>& result)
 {
-    // Init result to zero
-    #pragma omp parallel for simd
-    for(size_t i = 0; i < result.Length(); ++i)
-        result[i] = (T)0;
-    #pragma omp parallel for
-    for(size_t i = 0; i < mat.Height(); ++i)
-        for(size_t j = 0; j < mat.Width(); ++j)
-            result[j] += vect[i] * mat[i*mat.Width() + j];
+    constexpr size_t block = 1024;
+    const size_t height = mat.Height();
+    const size_t width = mat.Width();
+    const T* data = mat.Data();
+    T* res = result.Data();
+
+    #pragma omp parallel for schedule(static)
+    for(size_t jb = 0; jb < width; jb += block)
+    {
+        const size_t j_end = std::min(jb + block, width);
+        #pragma omp simd
+        for(size_t j = jb; j < j_end; ++j)
+            res[j] = (T)0;
+        for(size_t i = 0; i < height; ++i)
+        {
+            const T factor = vect[i];
+            const T* row = data + i*width;
+            #pragma omp simd
+            for(size_t j = jb; j < j_end; ++j)
+                res[j] += factor * row[j];
+        }
+    }
 }
 
 } // namespace alias
@@ -0,0 +1,138 @@
+///
+/// \file include/utils/linearop/matrix/cholesky.hpp
+/// \brief Cholesky factorization header
+/// \details Provide a blocked in-place Cholesky factorization of symmetric positive definite matrices and the associated solver.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_MATRIX_CHOLESKY_HPP
+#define ASTROQUT_UTILS_MATRIX_CHOLESKY_HPP
+
+#include "utils/linearop/matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace alias
+{
+
+inline constexpr size_t cholesky_block = 64; //!< Side of the diagonal blocks, the panel of a block stays in the L2 cache
+
+/** Blocked Cholesky factorization in-place
+ *  \brief Right-looking factorization A = L * L', the panel solve and the trailing update are split among the threads
+ *  \param A Symmetric positive definite square matrix, only its lower triangle is read. Replaced by L, upper triangle set to zero.
+ *  \param block Side of the diagonal blocks
+ *  \return False if A is not numerically positive definite, A is then left partially factorized
+ */
+template<class T>
+bool Cholesky(Matrix<T>& A, size_t block = cholesky_block)
+{
+#ifdef DO_ARGCHECKS
+    if( A.Height() != A.Width() )
+        throw std::invalid_argument("Cholesky factorization needs a square matrix!");
+#endif // DO_ARGCHECKS
+    const size_t n = A.Height();
+    T* a = A.Data();
+
+    for(size_t k_start = 0; k_start < n; k_start += block)
+    {
+        const size_t k_end = std::min(n, k_start + block);
+
+        // unblocked factorization of the diagonal block
+        for(size_t j = k_start; j < k_end; ++j)
+        {
+            T diagonal = a[j*n + j];
+            for(size_t p = k_start; p < j; ++p)
+                diagonal -= a[j*n + p] * a[j*n + p];
+            if( !(diagonal > (T)0) )
+                return false;
+            diagonal = std::sqrt(diagonal);
+            a[j*n + j] = diagonal;
+            for(size_t i = j + 1; i < k_end; ++i)
+            {
+                T sum = a[i*n + j];
+                for(size_t p = k_start; p < j; ++p)
+                    sum -= a[i*n + p] * a[j*n + p];
+                a[i*n + j] = sum / diagonal;
+            }
+        }
+
+        // panel below the diagonal block, L_panel * L_diagonal' = A_panel
+        #pragma omp parallel for
+        for(size_t i = k_end; i < n; ++i)
+        {
+            for(size_t j = k_start; j < k_end; ++j)
+            {
+                T sum = a[i*n + j];
+                for(size_t p = k_start; p < j; ++p)
+                    sum -= a[i*n + p] * a[j*n + p];
+                a[i*n + j] = sum / a[j*n + j];
+            }
+        }
+
+        // lower triangle of the trailing matrix, A_trailing -= L_panel * L_panel'
+        #pragma omp parallel for schedule(dynamic)
+        for(size_t i = k_end; i < n; ++i)
+        {
+            const T* row_i = a + i*n + k_start;
+            for(size_t j = k_end; j <= i; ++j)
+            {
+                const T* row_j = a + j*n + k_start;
+                T sum = 0;
+                #pragma omp simd reduction(+:sum)
+                for(size_t p = 0; p < k_end - k_start; ++p)
+                    sum += row_i[p] * row_j[p];
+                a[i*n + j] -= sum;
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(size_t i = 0; i < n; ++i)
+        std::fill(a + i*n + i + 1, a + (i+1)*n, (T)0);
+
+    return true;
+}
+
+/** Solve with a Cholesky factor
+ *  \param L Lower triangular factor computed by Cholesky
+ *  \param b Right hand side vector, replaced by the solution x of L * L' * x = b
+ */
+template<class T>
+void CholeskySolve(const Matrix<T>& L, Matrix<T>& b)
+{
+#ifdef DO_ARGCHECKS
+    if( L.Height() != L.Width() || b.Length() != L.Height() )
+        throw std::invalid_argument("Cholesky solve dimensions do not match!");
+#endif // DO_ARGCHECKS
+    const size_t n = L.Height();
+    const T* l = L.Data();
+    T* x = b.Data();
+
+    // L * y = b, rows of L are contiguous
+    for(size_t i = 0; i < n; ++i)
+    {
+        T sum = 0;
+        #pragma omp simd reduction(+:sum)
+        for(size_t p = 0; p < i; ++p)
+            sum += l[i*n + p] * x[p];
+        x[i] = (x[i] - sum) / l[i*n + i];
+    }
+
+    // L' * x = y, column oriented to keep walking the rows of L
+    for(size_t i = n; i-- > 0;)
+    {
+        x[i] /= l[i*n + i];
+        const T x_i = x[i];
+        #pragma omp simd
+        for(size_t p = 0; p < i; ++p)
+            x[p] -= l[i*n + p] * x_i;
+    }
+}
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_MATRIX_CHOLESKY_HPP
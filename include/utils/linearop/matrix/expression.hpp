@@ -0,0 +1,374 @@
+///
+/// \file include/utils/linearop/matrix/expression.hpp
+/// \brief Lazy element-wise Matrix expressions
+/// \details Provide expression templates to evaluate element-wise chains of Matrix operations and their final reduction in a single pass.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_MATRIX_EXPRESSION_HPP
+#define ASTROQUT_UTILS_MATRIX_EXPRESSION_HPP
+
+#include "utils/linearop/matrix.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+namespace alias
+{
+
+/** Base of every lazy expression
+ *  \brief Curiously recurring template, E is the derived expression type
+ */
+template <class E>
+class MatrixExpression
+{
+public:
+    /** Access the derived expression
+     *  \return A reference to the derived expression
+     */
+    const E& Self() const noexcept
+    {
+        return static_cast<const E&>(*this);
+    }
+
+    size_t Height() const noexcept
+    {
+        return Self().Height();
+    }
+    size_t Width() const noexcept
+    {
+        return Self().Width();
+    }
+    size_t Length() const noexcept
+    {
+        return Self().Height() * Self().Width();
+    }
+};
+
+template <class E>
+struct is_matrix_expression : std::is_base_of<MatrixExpression<E>, E> {};
+
+/** Leaf of an expression, refers to the data of an existing Matrix
+ */
+template <class T>
+class MatrixLeaf : public MatrixExpression<MatrixLeaf<T>>
+{
+private:
+    const T* data_; //!< Member variable "data_"
+    size_t height_; //!< Member variable "height_"
+    size_t width_; //!< Member variable "width_"
+
+public:
+    using value_type = T;
+
+    explicit MatrixLeaf(const Matrix<T>& mat) noexcept
+        : data_(mat.Data())
+        , height_(mat.Height())
+        , width_(mat.Width())
+    {}
+
+    size_t Height() const noexcept
+    {
+        return height_;
+    }
+    size_t Width() const noexcept
+    {
+        return width_;
+    }
+
+    T operator[](size_t index) const noexcept
+    {
+        return data_[index];
+    }
+};
+
+/** Element-wise operation between two expressions
+ */
+template <class L, class R, class Op>
+class BinaryExpression : public MatrixExpression<BinaryExpression<L, R, Op>>
+{
+private:
+    const L first_; //!< Member variable "first_"
+    const R second_; //!< Member variable "second_"
+
+public:
+    using value_type = typename L::value_type;
+
+    BinaryExpression(const L& first, const R& second)
+        : first_(first)
+        , second_(second)
+    {
+#ifdef DO_ARGCHECKS
+        if( first.Height()*first.Width() != second.Height()*second.Width() )
+            throw std::invalid_argument("Element-wise expression operands must have the same length!");
+#endif // DO_ARGCHECKS
+    }
+
+    size_t Height() const noexcept
+    {
+        return first_.Height();
+    }
+    size_t Width() const noexcept
+    {
+        return first_.Width();
+    }
+
+    value_type operator[](size_t index) const noexcept
+    {
+        return Op::Apply(first_[index], second_[index]);
+    }
+};
+
+/** Element-wise operation between an expression and a single number
+ */
+template <class E, class Op, bool number_first>
+class ScalarExpression : public MatrixExpression<ScalarExpression<E, Op, number_first>>
+{
+public:
+    using value_type = typename E::value_type;
+
+private:
+    const E expression_; //!< Member variable "expression_"
+    const value_type number_; //!< Member variable "number_"
+
+public:
+    ScalarExpression(const E& expression, value_type number) noexcept
+        : expression_(expression)
+        , number_(number)
+    {}
+
+    size_t Height() const noexcept
+    {
+        return expression_.Height();
+    }
+    size_t Width() const noexcept
+    {
+        return expression_.Width();
+    }
+
+    value_type operator[](size_t index) const noexcept
+    {
+        if( number_first )
+            return Op::Apply(number_, expression_[index]);
+        return Op::Apply(expression_[index], number_);
+    }
+};
+
+/** Element-wise function applied to an expression
+ */
+template <class E, class Op>
+class UnaryExpression : public MatrixExpression<UnaryExpression<E, Op>>
+{
+private:
+    const E expression_; //!< Member variable "expression_"
+
+public:
+    using value_type = typename E::value_type;
+
+    explicit UnaryExpression(const E& expression) noexcept
+        : expression_(expression)
+    {}
+
+    size_t Height() const noexcept
+    {
+        return expression_.Height();
+    }
+    size_t Width() const noexcept
+    {
+        return expression_.Width();
+    }
+
+    value_type operator[](size_t index) const noexcept
+    {
+        return Op::Apply(expression_[index]);
+    }
+};
+
+namespace expression
+{
+struct Add { template <class T> static T Apply(T first, T second) noexcept { return first + second; } };
+struct Sub { template <class T> static T Apply(T first, T second) noexcept { return first - second; } };
+struct Mul { template <class T> static T Apply(T first, T second) noexcept { return first * second; } };
+struct Div { template <class T> static T Apply(T first, T second) noexcept { return first / second; } };
+struct Log { template <class T> static T Apply(T value) noexcept { return std::log(value); } };
+struct Abs { template <class T> static T Apply(T value) noexcept { return std::abs(value); } };
+
+/** Turn a Matrix into a leaf, keep expressions as they are
+ */
+template <class T>
+MatrixLeaf<T> Wrap(const Matrix<T>& mat) noexcept
+{
+    return MatrixLeaf<T>(mat);
+}
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr>
+const E& Wrap(const E& expression) noexcept
+{
+    return expression;
+}
+
+template <class T>
+struct is_operand : is_matrix_expression<T> {};
+template <class T>
+struct is_operand<Matrix<T>> : std::true_type {};
+
+/** True if at least one operand is an expression and both are Matrix or expressions,
+ *  so that Matrix-only arithmetic keeps using the eager operators
+ */
+template <class L, class R>
+using enable_binary = std::enable_if_t<is_operand<L>::value && is_operand<R>::value && (is_matrix_expression<L>::value || is_matrix_expression<R>::value)>;
+
+template <class L, class R>
+using wrapped_t = std::decay_t<decltype(Wrap(std::declval<const L&>()))>;
+} // namespace expression
+
+/** Start a lazy expression
+ *  \param mat Matrix to refer to, must outlive the expression
+ *  \return A leaf expression
+ */
+template <class T>
+MatrixLeaf<T> Lazy(const Matrix<T>& mat) noexcept
+{
+    return MatrixLeaf<T>(mat);
+}
+
+/** Element-wise operators between expressions or an expression and a Matrix
+ *  \brief Same semantic as the eager Matrix operators: & is the element-wise product, / the element-wise division
+ */
+template <class L, class R, typename = expression::enable_binary<L, R>>
+auto operator+(const L& first, const R& second)
+{
+    return BinaryExpression<expression::wrapped_t<L, R>, expression::wrapped_t<R, L>, expression::Add>(expression::Wrap(first), expression::Wrap(second));
+}
+template <class L, class R, typename = expression::enable_binary<L, R>>
+auto operator-(const L& first, const R& second)
+{
+    return BinaryExpression<expression::wrapped_t<L, R>, expression::wrapped_t<R, L>, expression::Sub>(expression::Wrap(first), expression::Wrap(second));
+}
+template <class L, class R, typename = expression::enable_binary<L, R>>
+auto operator&(const L& first, const R& second)
+{
+    return BinaryExpression<expression::wrapped_t<L, R>, expression::wrapped_t<R, L>, expression::Mul>(expression::Wrap(first), expression::Wrap(second));
+}
+template <class L, class R, typename = expression::enable_binary<L, R>>
+auto operator/(const L& first, const R& second)
+{
+    return BinaryExpression<expression::wrapped_t<L, R>, expression::wrapped_t<R, L>, expression::Div>(expression::Wrap(first), expression::Wrap(second));
+}
+
+/** Element-wise operators between an expression and a single number
+ */
+template <class E, class U, typename std::enable_if_t<is_matrix_expression<E>::value && std::is_arithmetic<U>::value>* = nullptr>
+ScalarExpression<E, expression::Add, false> operator+(const E& expression, U number)
+{
+    return ScalarExpression<E, expression::Add, false>(expression, number);
+}
+template <class E, class U, typename std::enable_if_t<is_matrix_expression<E>::value && std::is_arithmetic<U>::value>* = nullptr>
+ScalarExpression<E, expression::Sub, false> operator-(const E& expression, U number)
+{
+    return ScalarExpression<E, expression::Sub, false>(expression, number);
+}
+template <class E, class U, typename std::enable_if_t<is_matrix_expression<E>::value && std::is_arithmetic<U>::value>* = nullptr>
+ScalarExpression<E, expression::Mul, false> operator*(const E& expression, U number)
+{
+    return ScalarExpression<E, expression::Mul, false>(expression, number);
+}
+template <class E, class U, typename std::enable_if_t<is_matrix_expression<E>::value && std::is_arithmetic<U>::value>* = nullptr>
+ScalarExpression<E, expression::Mul, true> operator*(U number, const E& expression)
+{
+    return ScalarExpression<E, expression::Mul, true>(expression, number);
+}
+template <class E, class U, typename std::enable_if_t<is_matrix_expression<E>::value && std::is_arithmetic<U>::value>* = nullptr>
+ScalarExpression<E, expression::Div, false> operator/(const E& expression, U number)
+{
+    return ScalarExpression<E, expression::Div, false>(expression, number);
+}
+
+/** Element-wise functions
+ */
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr>
+UnaryExpression<E, expression::Log> Log(const E& expression)
+{
+    return UnaryExpression<E, expression::Log>(expression);
+}
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr>
+UnaryExpression<E, expression::Abs> Abs(const E& expression)
+{
+    return UnaryExpression<E, expression::Abs>(expression);
+}
+
+/** Sum of an expression
+ *  \brief Evaluates the whole chain in a single vectorized pass
+ *  \param expression Expression to reduce
+ *  \return The result of the accumulator type of T, double for single precision expressions
+ */
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr, class T = typename AccumulatorType<typename E::value_type>::type>
+T Sum(const E& expression)
+{
+    return reduction::Sum<T>(expression.Length(), [&expression](size_t i){ return (T) expression[i]; });
+}
+
+/** Norm of an expression
+ *  \brief Evaluates the whole chain in a single vectorized pass
+ *  \param expression Expression to reduce
+ *  \param l_norm Type of norm
+ *  \return The result of type double
+ */
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr>
+double Norm(const E& expression, const NormType l_norm)
+{
+    const size_t length = expression.Length();
+    switch(l_norm)
+    {
+    case one:
+    {
+        return reduction::Sum<double>(length, [&expression](size_t i){ return (double) std::abs(expression[i]); });
+    }
+    case two:
+    {
+        return std::sqrt(Norm(expression, two_squared));
+    }
+    case two_squared:
+    {
+        return reduction::Sum<double>(length, [&expression](size_t i){ return (double) std::norm(expression[i]); });
+    }
+    case inf:
+    {
+        return reduction::Max<double>(length, [&expression](size_t i){ return (double) std::abs(expression[i]); });
+    }
+    default:
+    {
+        return 0.0L;
+    }
+    }
+}
+
+/** Sum, one norm, squared two norm, min and max of an expression
+ *  \brief Evaluates the whole chain once for all the results
+ *  \param expression Expression to reduce
+ *  \return The results of type double
+ */
+template <class E, typename std::enable_if_t<is_matrix_expression<E>::value>* = nullptr>
+reduction::Summary Summarize(const E& expression)
+{
+    return reduction::Summarize(expression.Length(), [&expression](size_t i){ return (double) expression[i]; });
+}
+
+/** Inner product of two expressions, or of an expression and a Matrix
+ *  \brief Evaluates both chains in a single vectorized pass
+ *  \param first Vector
+ *  \param second Vector
+ *  \return The result of the accumulator type of T
+ */
+template <class L, class R, typename = expression::enable_binary<L, R>>
+auto Inner(const L& first, const R& second)
+{
+    return Sum(first & second);
+}
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_MATRIX_EXPRESSION_HPP
@@ -0,0 +1,192 @@
+///
+/// \file include/utils/linearop/matrix/view.hpp
+/// \brief Matrix view class header
+/// \details Provide a non-owning, strided window over Matrix data.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_MATRIX_VIEW_HPP
+#define ASTROQUT_UTILS_MATRIX_VIEW_HPP
+
+#include "utils/linearop/matrix.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace alias
+{
+
+template <class T = double>
+class MatrixView
+{
+private:
+    T* data_; //!< Member variable "data_" top left element, not owned
+    size_t height_; //!< Member variable "height_"
+    size_t width_; //!< Member variable "width_"
+    size_t stride_; //!< Member variable "stride_" distance between the first elements of two consecutive rows
+
+public:
+    /** Default constructor
+     *  Create an empty view
+     */
+    MatrixView() noexcept
+        : data_(nullptr)
+        , height_(0)
+        , width_(0)
+        , stride_(0)
+    {
+#ifdef DEBUG
+        std::cout << "MatrixView : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Full member constructor
+     *  \param data Top left element of the viewed data, must outlive the view
+     *  \param height Height of the view
+     *  \param width Width of the view
+     *  \param stride Distance between two consecutive rows, at least width
+     */
+    MatrixView(T* data, size_t height, size_t width, size_t stride) noexcept
+        : data_(data)
+        , height_(height)
+        , width_(width)
+        , stride_(stride)
+    {
+#ifdef DEBUG
+        std::cout << "MatrixView : Full member constructor called with data=" << data << ", height=" << height << ", width=" << width << ", stride=" << stride << std::endl;
+#endif // DEBUG
+    }
+
+    /** Contiguous constructor
+     *  \param data Top left element of the viewed data, must outlive the view
+     *  \param height Height of the view
+     *  \param width Width of the view
+     */
+    MatrixView(T* data, size_t height, size_t width) noexcept
+        : MatrixView(data, height, width, width)
+    {}
+
+    /** Matrix constructor
+     *  \param mat Matrix to view entirely, must outlive the view
+     */
+    MatrixView(const Matrix<T>& mat) noexcept
+        : MatrixView(mat.Data(), mat.Height(), mat.Width(), mat.Width())
+    {}
+
+    T* Data() const noexcept
+    {
+        return data_;
+    }
+    size_t Height() const noexcept
+    {
+        return height_;
+    }
+    size_t Width() const noexcept
+    {
+        return width_;
+    }
+    size_t Stride() const noexcept
+    {
+        return stride_;
+    }
+    size_t Length() const noexcept
+    {
+        return height_ * width_;
+    }
+
+    /** Contiguity test
+     *  \return True if the rows follow each other in memory
+     */
+    bool IsContiguous() const noexcept
+    {
+        return stride_ == width_ || height_ <= 1;
+    }
+
+    /** Element access
+     *  \param row Row of the element
+     *  \param col Column of the element
+     *  \return A reference to the element
+     */
+    T& operator()(size_t row, size_t col) const noexcept
+    {
+        return data_[row*stride_ + col];
+    }
+
+    /** Linear element access
+     *  \param index Row-major index of the element, the view must be contiguous
+     *  \return A reference to the element
+     */
+    T& operator[](size_t index) const noexcept
+    {
+        return data_[index];
+    }
+
+    /** Sub-block of the view
+     *  \param row Top row of the block
+     *  \param col Left column of the block
+     *  \param height Height of the block
+     *  \param width Width of the block
+     *  \return A view on the block, sharing the stride of this
+     */
+    MatrixView Block(size_t row, size_t col, size_t height, size_t width) const
+    {
+#ifdef DO_ARGCHECKS
+        if( row + height > height_ || col + width > width_ )
+            throw std::invalid_argument("Block must lie inside the view!");
+#endif // DO_ARGCHECKS
+        return MatrixView(data_ + row*stride_ + col, height, width, stride_);
+    }
+
+    /** Single row of the view
+     *  \param row Row to view
+     *  \return A 1 by width view
+     */
+    MatrixView Row(size_t row) const
+    {
+        return Block(row, 0, 1, width_);
+    }
+
+    /** Segment of a vector view
+     *  \param start First element of the segment
+     *  \param length Length of the segment
+     *  \return A contiguous length by 1 view
+     */
+    MatrixView Segment(size_t start, size_t length) const
+    {
+#ifdef DO_ARGCHECKS
+        if( !IsContiguous() || start + length > Length() )
+            throw std::invalid_argument("Segment must lie inside a contiguous view!");
+#endif // DO_ARGCHECKS
+        return MatrixView(data_ + start, length, 1, 1);
+    }
+
+    /** Borrowed Matrix
+     *  \brief Matrix sharing the data of the view, it never frees it. Usable by every Matrix kernel and operator.
+     *  \return A non-owning Matrix
+     */
+    Matrix<T> Borrow() const
+    {
+        if( !IsContiguous() )
+            throw std::invalid_argument("Only contiguous views can be borrowed as a Matrix, use Copy instead!");
+        return Matrix<T>(data_, height_, width_, Matrix<T>::borrowed);
+    }
+
+    /** Owning copy
+     *  \return A new contiguous Matrix with the viewed data
+     */
+    Matrix<T> Copy() const
+    {
+        Matrix<T> result(height_, width_);
+        #pragma omp parallel for
+        for(size_t row = 0; row < height_; ++row)
+            std::copy(data_ + row*stride_, data_ + row*stride_ + width_, result.Data() + row*width_);
+        return result;
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_MATRIX_VIEW_HPP
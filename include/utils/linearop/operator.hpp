@@ -12,9 +12,15 @@
 #define ASTROQUT_UTILS_OPERATOR_HPP
 
 #include "utils/linearop/matrix.hpp"
+#include "utils/linearop/matrix/view.hpp"
+#include "utils/shared.hpp"
+#include "utils/workspace.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <utility>
+#include <vector>
 
 namespace alias
 {
@@ -23,7 +29,7 @@ template<class T = double>
 class Operator : public LinearOp
 {
 protected:
-    Matrix<T> data_; //!< Member variable "data_"
+    Shared<Matrix<T>> data_; //!< Member variable "data_" shared between copies, see Shared::Mutable before writing
     bool transposed_; //!< Member variable "transposed_"
 
 public:
@@ -39,6 +45,7 @@ public:
     }
 
     /** Copy constructor
+     *  \brief The data is shared with other, not copied
      *  \param other Object to copy from
      */
     Operator(const Operator& other)
@@ -83,9 +90,9 @@ public:
      *  \param width Width of the operator
      *  \param transposed If the operator is transposed
      */
-    Operator(Matrix<T> data, size_t height, size_t width, bool transposed) noexcept
+    Operator(Matrix<T> data, size_t height, size_t width, bool transposed)
         : LinearOp(height, width)
-        , data_(Matrix<T>(data))
+        , data_(std::move(data))
         , transposed_(transposed)
     {
 #ifdef DEBUG
@@ -112,12 +119,12 @@ public:
      */
     const Matrix<T>& Data() const noexcept
     {
-        return data_;
+        return *data_;
     }
     /** Set data_
      * \param data New value to set
      */
-    void Data(const Matrix<T>& data) noexcept
+    void Data(const Matrix<T>& data)
     {
         data_ = data;
     }
@@ -137,9 +144,9 @@ public:
      *  \param index Array subscript
      *  \return A reference to the array element at index
      */
-    T& operator[](size_t index) noexcept
+    T& operator[](size_t index)
     {
-        return data_[index];
+        return data_.Mutable()[index];
     }
 
     /** Array subscript getter operator
@@ -149,12 +156,12 @@ public:
     template <class S = T, typename std::enable_if_t<std::is_arithmetic<S>::value>* = nullptr>
     const S operator[](size_t index) const noexcept
     {
-        return data_[index];
+        return (*data_)[index];
     }
     template <class S = T, typename std::enable_if_t<is_complex<S> {}>* = nullptr>
     const S& operator[](size_t index) const noexcept
     {
-        return data_[index];
+        return (*data_)[index];
     }
 
     /** Transpose in-place
@@ -181,7 +188,7 @@ public:
      */
     bool operator==(const Operator& other) const noexcept
     {
-        if( this->height_ != other.height_ || this->width_ != other.width_ || data_ != other.data_ )
+        if( this->height_ != other.height_ || this->width_ != other.width_ || *data_ != *other.data_ )
             return false;
 
         return true;
@@ -210,6 +217,104 @@ public:
     }
 
     virtual Matrix<T> operator*(const Matrix<T>& other) const = 0;
+
+    /** Out-of-place application
+     *  \brief Generic version going through operator*, the operators used in the iterative loops override it
+     *  so that the result is written in place and the temporaries are taken from the workspace
+     *  \param in Operand, contiguous
+     *  \param out Result, must not overlap in
+     *  \param workspace Scratch memory, left as it was found
+     */
+    virtual void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const
+    {
+        (void) workspace;
+        Matrix<T> result = *this * in.Borrow();
+#ifdef DO_ARGCHECKS
+        if( result.Height() != out.Height() || result.Width() != out.Width() )
+            throw std::invalid_argument("Result view of Apply does not match the operator dimensions!");
+#endif // DO_ARGCHECKS
+        #pragma omp parallel for
+        for(size_t row = 0; row < out.Height(); ++row)
+            std::copy(result.Data() + row*out.Width(), result.Data() + (row+1)*out.Width(), &out(row, 0));
+    }
+
+    /** Weighted Gram matrix
+     *  \brief Generic version, the columns are obtained through products with the canonical basis
+     *  \param weights Non-negative weights of the rows, height by 1
+     *  \return The width by width matrix A' * diag(weights) * A
+     */
+    virtual Matrix<T> WeightedGram(const Matrix<T>& weights) const
+    {
+        Matrix<T> columns(this->height_, this->width_);
+        Matrix<T> unit((T)0, this->width_, 1);
+        for(size_t col = 0; col < this->width_; ++col)
+        {
+            unit[col] = (T)1;
+            Matrix<T> column = *this * unit;
+            unit[col] = (T)0;
+            #pragma omp parallel for simd
+            for(size_t row = 0; row < this->height_; ++row)
+                columns[row*this->width_ + col] = column[row];
+        }
+
+        Matrix<T> result((T)0, this->width_, this->width_);
+        DenseWeightedGram(columns.Data(), this->height_, this->width_, this->width_, weights, result.Data(), this->width_);
+        SymmetrizeLower(result);
+        return result;
+    }
+
+protected:
+    /** Lower triangle of a dense weighted Gram matrix
+     *  \brief Rows are processed by chunks, whose weighted columns are stored contiguously so that
+     *  every entry of the Gram matrix is a vectorized dot product over the chunk
+     *  \param data Top left element of the row-major height by width matrix
+     *  \param height Height of the matrix
+     *  \param width Width of the matrix
+     *  \param stride Distance between two consecutive rows of data
+     *  \param weights Non-negative weights of the rows
+     *  \param gram Top left element of the Gram matrix, its lower triangle is accumulated into
+     *  \param gram_stride Distance between two consecutive rows of gram
+     */
+    static void DenseWeightedGram(const T* data, size_t height, size_t width, size_t stride, const Matrix<T>& weights, T* gram, size_t gram_stride)
+    {
+        const size_t chunk = 128;
+        std::vector<T> scaled(width * chunk);
+        for(size_t row_start = 0; row_start < height; row_start += chunk)
+        {
+            const size_t rows = std::min(chunk, height - row_start);
+
+            // square root of the weights on both sides, stored column by column
+            #pragma omp parallel for
+            for(size_t col = 0; col < width; ++col)
+                for(size_t row = 0; row < rows; ++row)
+                    scaled[col*chunk + row] = std::sqrt(weights[row_start + row]) * data[(row_start + row)*stride + col];
+
+            #pragma omp parallel for schedule(dynamic)
+            for(size_t i = 0; i < width; ++i)
+            {
+                for(size_t j = 0; j <= i; ++j)
+                {
+                    T sum = 0;
+                    #pragma omp simd reduction(+:sum)
+                    for(size_t row = 0; row < rows; ++row)
+                        sum += scaled[i*chunk + row] * scaled[j*chunk + row];
+                    gram[i*gram_stride + j] += sum;
+                }
+            }
+        }
+    }
+
+    /** Copy the lower triangle of a square matrix to its upper triangle
+     *  \param mat Square matrix
+     */
+    static void SymmetrizeLower(Matrix<T>& mat)
+    {
+        const size_t n = mat.Height();
+        #pragma omp parallel for
+        for(size_t i = 0; i < n; ++i)
+            for(size_t j = i + 1; j < n; ++j)
+                mat[i*n + j] = mat[j*n + i];
+    }
 };
 
 } // namespace alias
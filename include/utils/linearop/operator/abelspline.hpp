@@ -0,0 +1,331 @@
+///
+/// \file include/utils/linearop/operator/abelspline.hpp
+/// \brief Precomposed Abel transform and spline class header
+/// \details Provide the product of the Abel transform and the spline operator as a single table, reduced by the Abel quadrant symmetry.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_OPERATOR_ABELSPLINE_HPP
+#define ASTROQUT_UTILS_OPERATOR_ABELSPLINE_HPP
+
+#include "utils/linearop/matrix/view.hpp"
+#include "utils/linearop/operator.hpp"
+#include "utils/linearop/operator/abeltransform.hpp"
+#include "utils/linearop/operator/matmult/spline.hpp"
+#include "utils/shared.hpp"
+
+#include <vector>
+
+namespace alias
+{
+
+template<class T = double>
+class AbelSpline : public Operator<T>
+{
+private:
+    /** Composed table
+     *  \brief Every row of the compressed Abel matrix times the first half of the spline matrix gives a row of left,
+     *  times its mirrored second half a row of right, restricted to the columns where that half is non-zero.
+     */
+    struct Composed
+    {
+        Matrix<T> left; //!< Member variable "left" rows of the left quadrants, pic_side^2/4 by left_width
+        Matrix<T> right; //!< Member variable "right" rows of the right quadrants, pic_side^2/4 by right_width
+        size_t left_begin = 0; //!< Member variable "left_begin" first spline coefficient of the left columns
+        size_t left_width = 0; //!< Member variable "left_width" amount of left columns
+        size_t right_begin = 0; //!< Member variable "right_begin" first spline coefficient of the right columns
+        size_t right_width = 0; //!< Member variable "right_width" amount of right columns
+    };
+
+    size_t pic_side_; //!< Member variable "pic_side_" side of the picture in pixel
+    Shared<Composed> table_; //!< Member variable "table_" composed table shared between copies
+
+public:
+
+    /** Default constructor
+     */
+    AbelSpline()
+        : Operator<T>()
+        , pic_side_(0)
+        , table_()
+    {
+#ifdef DEBUG
+        std::cout << "AbelSpline : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Copy constructor
+     *  \brief The composed table is shared with other, not copied
+     *  \param other Object to copy from
+     */
+    AbelSpline(const AbelSpline& other)
+        : Operator<T>(other)
+        , pic_side_(other.pic_side_)
+        , table_(other.table_)
+    {
+#ifdef DEBUG
+        std::cout << "AbelSpline : Copy constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Move constructor
+     *  \param other Object to move from
+     */
+    AbelSpline(AbelSpline&& other)
+        : AbelSpline()
+    {
+#ifdef DEBUG
+        std::cout << "AbelSpline : Move constructor called" << std::endl;
+#endif // DEBUG
+        swap(*this, other);
+    }
+
+    /** Build constructor
+     *  \brief Composes the compressed Abel matrix with the spline matrix, in their forward orientation whatever their transposition
+     *  \param abel Abel transform of a pic_side by pic_side picture with pic_side wavelets
+     *  \param spline Spline operator of the same picture
+     */
+    explicit AbelSpline(const AbelTransform<T>& abel, const Spline<T>& spline)
+        : Operator<T>(Matrix<T>(), spline.Data().Height()*spline.Data().Height(), spline.Data().Width(), false)
+        , pic_side_(spline.Data().Height())
+        , table_()
+    {
+#ifdef DEBUG
+        std::cout << "AbelSpline : Build constructor called" << std::endl;
+#endif // DEBUG
+#ifdef DO_ARGCHECKS
+        if( abel.Table().width != pic_side_/2 || abel.Table().Rows() != (pic_side_/2)*(pic_side_/2) )
+            throw std::invalid_argument("Abel transform and spline operator of different picture sizes!");
+#endif // DO_ARGCHECKS
+
+        const Matrix<T>& spline_data = spline.Data();
+        const size_t pic_side_half = pic_side_/2;
+        const size_t columns = spline_data.Width();
+        const size_t rows = pic_side_half*pic_side_half;
+
+        // non-zero columns of each half of the spline matrix
+        auto span = [&](size_t row_begin, size_t& begin, size_t& width)
+        {
+            size_t first = columns;
+            size_t last = 0;
+            for( size_t row = row_begin; row < row_begin + pic_side_half; ++row )
+                for( size_t col = 0; col < columns; ++col )
+                    if( spline_data[row*columns + col] != (T)0 )
+                    {
+                        first = std::min(first, col);
+                        last = std::max(last, col + 1);
+                    }
+            begin = first < last ? first : 0;
+            width = first < last ? last - first : 0;
+        };
+        Composed composed;
+        span(0, composed.left_begin, composed.left_width);
+        span(pic_side_half, composed.right_begin, composed.right_width);
+        composed.left = Matrix<T>((T)0, rows, composed.left_width);
+        composed.right = Matrix<T>((T)0, rows, composed.right_width);
+
+        #pragma omp parallel
+        {
+            std::vector<T> abel_row(abel.Table().width);
+            #pragma omp for schedule(dynamic, 16)
+            for( size_t row = 0; row < rows; ++row )
+            {
+                const size_t length = abel.Row(row, abel_row.data());
+                T* left = composed.left.Data() + row*composed.left_width;
+                T* right = composed.right.Data() + row*composed.right_width;
+                for( size_t k = 0; k < length; ++k )
+                {
+                    const T abel_value = abel_row[k];
+                    const T* left_spline = spline_data.Data() + k*columns + composed.left_begin;
+                    const T* right_spline = spline_data.Data() + (pic_side_ - k - 1)*columns + composed.right_begin;
+                    #pragma omp simd
+                    for( size_t col = 0; col < composed.left_width; ++col )
+                        left[col] += abel_value * left_spline[col];
+                    #pragma omp simd
+                    for( size_t col = 0; col < composed.right_width; ++col )
+                        right[col] += abel_value * right_spline[col];
+                }
+            }
+        }
+        table_ = std::move(composed);
+    }
+
+    /** Clone function
+     *  \return A copy of the current instance
+     */
+    AbelSpline* Clone() const override final
+    {
+        return new AbelSpline(*this);
+    }
+
+    /** Default destructor
+     */
+    virtual ~AbelSpline()
+    {
+#ifdef DEBUG
+        std::cout << "AbelSpline : Destructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Valid instance test
+     *  \return Throws an error message if instance is not valid.
+     */
+    bool IsValid() const override final
+    {
+        if( this->height_ != 0 && this->width_ != 0 && pic_side_ != 0 )
+            return true;
+
+        throw std::invalid_argument("Operator dimensions must be non-zero and the table shall be built!");
+    }
+
+    /** Empty test
+     *  \return True if no table was composed
+     */
+    bool IsEmpty() const noexcept
+    {
+        return pic_side_ == 0;
+    }
+
+    /** Memory footprint
+     *  \return The amount of bytes of the composed table
+     */
+    size_t Bytes() const noexcept
+    {
+        return (table_->left.Length() + table_->right.Length())*sizeof(T);
+    }
+
+    /** Swap function
+     *  \param first First object to swap
+     *  \param second Second object to swap
+     */
+    friend void swap(AbelSpline& first, AbelSpline& second) noexcept
+    {
+        using std::swap;
+
+        swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
+        swap(first.pic_side_, second.pic_side_);
+        swap(first.table_, second.table_);
+    }
+
+    /** Copy assignment operator
+     *  \param other Object to assign to current object
+     *  \return A reference to this
+     */
+    AbelSpline& operator=(AbelSpline other)
+    {
+        swap(*this, other);
+
+        return *this;
+    }
+
+    Matrix<T> operator*(const Matrix<T>& other) const override final
+    {
+#ifdef DEBUG
+        std::cerr << "AbelSpline: operator* called" << std::endl;
+#endif // DEBUG
+#ifdef DO_ARGCHECKS
+        try
+        {
+            this->ArgTest(other, mult);
+        }
+        catch (const std::exception&)
+        {
+            throw;
+        }
+#endif // DO_ARGCHECKS
+
+        Matrix<T> result(this->height_, 1);
+        Apply(other, result, Workspace::Local());
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \brief The forward product is one dot product per composed row and quadrant half, written to two symmetric pixels.
+     *  The transposed one sums the symmetric pixels of every composed row and streams the table once.
+     *  \param in Spline coefficients or picture vector
+     *  \param out Picture vector or spline coefficients, contiguous and not overlapping in, overwritten
+     *  \param workspace Scratch memory for the quadrant halves, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+#ifdef DO_ARGCHECKS
+        if( in.Length() != this->width_ || out.Length() != this->height_ || !out.IsContiguous() )
+            throw std::invalid_argument("Views of Apply do not match the operator dimensions!");
+#endif // DO_ARGCHECKS
+        Workspace::Frame frame(workspace);
+
+        const Composed& table = *table_;
+        const size_t pic_side_half = pic_side_/2;
+        const size_t rows = pic_side_half*pic_side_half;
+        Matrix<T> left = MatrixView<T>(workspace.Allocate<T>(rows), rows, 1).Borrow();
+        Matrix<T> right = MatrixView<T>(workspace.Allocate<T>(rows), rows, 1).Borrow();
+
+        if( !this->transposed_ )
+        {
+            if( table.left_width == 0 )
+                std::fill(left.Data(), left.Data() + rows, (T)0);
+            else
+                MatrixVectorMult(table.left, in.Segment(table.left_begin, table.left_width).Borrow(), left);
+            if( table.right_width == 0 )
+                std::fill(right.Data(), right.Data() + rows, (T)0);
+            else
+                MatrixVectorMult(table.right, in.Segment(table.right_begin, table.right_width).Borrow(), right);
+
+            #pragma omp parallel for
+            for( size_t row = 0; row < rows; ++row )
+            {
+                const size_t block = row / pic_side_half;
+                const size_t i = row % pic_side_half;
+                out[block*pic_side_ + i] = left[row];
+                out[block*pic_side_ + pic_side_ - i - 1] = left[row];
+                out[(pic_side_ - block - 1)*pic_side_ + i] = right[row];
+                out[(pic_side_ - block - 1)*pic_side_ + pic_side_ - i - 1] = right[row];
+            }
+            return;
+        }
+
+        #pragma omp parallel for
+        for( size_t row = 0; row < rows; ++row )
+        {
+            const size_t block = row / pic_side_half;
+            const size_t i = row % pic_side_half;
+            left[row] = in[block*pic_side_ + i] + in[block*pic_side_ + pic_side_ - i - 1];
+            right[row] = in[(pic_side_ - block - 1)*pic_side_ + i] + in[(pic_side_ - block - 1)*pic_side_ + pic_side_ - i - 1];
+        }
+
+        std::fill(out.Data(), out.Data() + out.Length(), (T)0);
+        Matrix<T> product = MatrixView<T>(workspace.Allocate<T>(std::max(table.left_width, table.right_width)), 1, std::max(table.left_width, table.right_width)).Borrow();
+        if( table.left_width != 0 )
+        {
+            VectorMatrixMult(left, table.left, product);
+            #pragma omp parallel for simd
+            for( size_t col = 0; col < table.left_width; ++col )
+                out[table.left_begin + col] += product[col];
+        }
+        if( table.right_width != 0 )
+        {
+            VectorMatrixMult(right, table.right, product);
+            #pragma omp parallel for simd
+            for( size_t col = 0; col < table.right_width; ++col )
+                out[table.right_begin + col] += product[col];
+        }
+    }
+
+    /** Transpose in-place
+     *   \brief The composed table does not move, the products pick the kernels of the transposed operator
+     *   \return A reference to this
+     */
+    AbelSpline& Transpose() override final
+    {
+        std::swap(this->height_, this->width_);
+        this->transposed_ = !this->transposed_;
+        return *this;
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_OPERATOR_ABELSPLINE_HPP
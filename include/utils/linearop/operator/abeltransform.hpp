@@ -11,7 +11,14 @@
 #ifndef ASTROQUT_UTILS_OPERATOR_ABELTRANSFORM_HPP
 #define ASTROQUT_UTILS_OPERATOR_ABELTRANSFORM_HPP
 
+#include "utils/bfloat16.hpp"
 #include "utils/linearop/operator.hpp"
+#include "utils/shared.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
 #ifdef DEBUG
 #include <sstream>
@@ -20,12 +27,59 @@
 namespace alias
 {
 
+/** Storage precision of the compressed Abel matrix
+ */
+enum AbelStorage {abel_full,        //!< elements stored in the precision of the operator
+                  abel_single,      //!< elements stored in single precision, products accumulated in double
+                  abel_bfloat16,    //!< elements stored in bfloat16, products accumulated in double
+                  abel_on_the_fly}; //!< elements computed by the products from the geometry, memory linear in the picture side
+
 template<class T = double>
 class AbelTransform : public Operator<T>
 {
+public:
+    /** Compressed Abel matrix
+     *  \brief Every row of the compressed matrix is non-zero on a prefix only, the prefixes are stored one after the other
+     *  in the precision given by storage, only the vector of that precision is filled. The geometry the elements are
+     *  computed from is kept when the matrix was generated, it is all there is for abel_on_the_fly.
+     */
+    struct Packed
+    {
+        std::vector<size_t> row_start; //!< Member variable "row_start" first element of every row, one more entry than rows
+        size_t width = 0; //!< Member variable "width" width of the compressed matrix
+        AbelStorage storage = abel_full; //!< Member variable "storage" precision of the elements
+        std::vector<T> values_full; //!< Member variable "values_full" elements in the precision of the operator
+        std::vector<float> values_single; //!< Member variable "values_single" elements in single precision
+        std::vector<Bfloat16> values_bfloat16; //!< Member variable "values_bfloat16" elements in bfloat16
+        std::vector<T> x_axis; //!< Member variable "x_axis" outer radius of every shell
+        std::vector<T> y_axis; //!< Member variable "y_axis" horizontal distance of every pixel column to the centre
+        std::vector<T> z_axis; //!< Member variable "z_axis" vertical distance of every pixel row to the centre
+
+        /** Amount of rows
+         *  \return The height of the compressed matrix
+         */
+        size_t Rows() const noexcept
+        {
+            return row_start.empty() ? y_axis.size()*z_axis.size() : row_start.size() - 1;
+        }
+
+        /** Memory footprint
+         *  \return The amount of bytes of the offsets, of the stored elements and of the geometry
+         */
+        size_t Bytes() const noexcept
+        {
+            return row_start.size()*sizeof(size_t) + values_full.size()*sizeof(T) + values_single.size()*sizeof(float) + values_bfloat16.size()*sizeof(Bfloat16)
+                   + (x_axis.size() + y_axis.size() + z_axis.size())*sizeof(T);
+        }
+    };
+
 private:
     size_t pic_side_;
     size_t wavelet_amount_;
+    Shared<Packed> table_; //!< Member variable "table_" compressed Abel matrix shared between copies
+
+    static constexpr size_t column_tile = 64; //!< Signal columns processed together by the multi-column kernels
+    static constexpr size_t row_range = 64/sizeof(T) > 0 ? 64/sizeof(T) : 1; //!< Result rows of a transposed task, one cache line
 
 public:
 
@@ -35,6 +89,7 @@ public:
         : Operator<T>()
         , pic_side_(0)
         , wavelet_amount_(0)
+        , table_()
     {
 #ifdef DEBUG
         std::cerr << "AbelTransform : Default constructor called." << std::endl;
@@ -48,6 +103,7 @@ public:
         : Operator<T>(other)
         , pic_side_(other.pic_side_)
         , wavelet_amount_(other.wavelet_amount_)
+        , table_(other.table_)
     {
 #ifdef DEBUG
         std::cout << "AbelTransform : Copy constructor called" << std::endl;
@@ -71,10 +127,11 @@ public:
      *  \param height Height of the full Abel matrix
      *  \param width Width of the full Abel matrix
      */
-    explicit AbelTransform(Matrix<T> data, size_t height, size_t width)
-        : Operator<T>(data, height, width, false)
+    explicit AbelTransform(const Matrix<T>& data, size_t height, size_t width)
+        : Operator<T>(Matrix<T>(), height, width, false)
         , pic_side_(height)
         , wavelet_amount_(height)
+        , table_(Pack(data))
     {
 #ifdef DEBUG
         std::cout << "AbelTransform : Full member constructor called" << std::endl;
@@ -86,13 +143,14 @@ public:
      *  \param wavelet_amount Power of 2 amount of wavelets, typically (pixel_amount/2)^2
      *  \param pixel_amount Total amount of pixels of the target picture
      *  \param radius Amount of pixels from centre to border of galaxy, typically pixel_amount/2
+     *  \param storage Precision of the stored elements
      */
-    explicit AbelTransform(unsigned int wavelets_amount, unsigned int pixel_amount, unsigned int radius)
-        : Operator<T>(Matrix<T>((T) 0, pixel_amount/4, wavelets_amount/2), pixel_amount, wavelets_amount, false)
+    explicit AbelTransform(unsigned int wavelets_amount, unsigned int pixel_amount, unsigned int radius, AbelStorage storage = abel_full)
+        : Operator<T>(Matrix<T>(), pixel_amount, wavelets_amount, false)
         , pic_side_(std::sqrt(pixel_amount))
         , wavelet_amount_(wavelets_amount)
+        , table_(Generate(radius, storage))
     {
-        Generate(this->data_, radius);
 #ifdef DEBUG
         std::cout << "AbelTransform : Build constructor called" << std::endl;
 #endif // DEBUG
@@ -120,12 +178,58 @@ public:
      */
     bool IsValid() const override final
     {
-        if( this->height_ != 0 && this->width_ != 0 && !this->data_.IsEmpty() )
+        if( this->height_ != 0 && this->width_ != 0 && table_->Rows() != 0 )
             return true;
 
         throw std::invalid_argument("Operator dimensions must be non-zero and data shall not be nullptr!");
     }
 
+    /** Access table_
+     *  \return A reference to the compressed Abel matrix
+     */
+    const Packed& Table() const noexcept
+    {
+        return *table_;
+    }
+
+    /** Row of the compressed Abel matrix
+     *  \param row Row of the compressed Abel matrix
+     *  \param coefficients Row of at least Table().width elements, the non-zero prefix is written in the precision of the operator
+     *  \return The length of the non-zero prefix
+     */
+    size_t Row(size_t row, T* coefficients) const
+    {
+        const Packed& table = *table_;
+        if( table.storage == abel_on_the_fly )
+            return GenerateRow(table, row, 0, table.width, coefficients);
+
+        const size_t start = table.row_start[row];
+        const size_t length = table.row_start[row+1] - start;
+        for( size_t position = 0; position < length; ++position )
+        {
+            if( table.storage == abel_single )
+                coefficients[position] = (T) table.values_single[start + position];
+            else if( table.storage == abel_bfloat16 )
+                coefficients[position] = (T) (float) table.values_bfloat16[start + position];
+            else
+                coefficients[position] = table.values_full[start + position];
+        }
+        return length;
+    }
+
+    /** Dense compressed Abel matrix
+     *  \return The compressed Abel matrix of size pixel_amount/4 * wavelets_amount/2, zeros included
+     */
+    Matrix<T> Unpack() const
+    {
+        const Packed& table = *table_;
+        Matrix<T> result((T)0, table.Rows(), table.width);
+        #pragma omp parallel for
+        for( size_t row = 0; row < table.Rows(); ++row )
+            Row(row, result.Data() + row*table.width);
+        return result;
+    }
+
     /** Swap function
      *  \param first First object to swap
      *  \param second Second object to swap
@@ -137,6 +241,7 @@ public:
         swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
         swap(first.pic_side_, second.pic_side_);
         swap(first.wavelet_amount_, second.wavelet_amount_);
+        swap(first.table_, second.table_);
     }
 
     /** Copy assignment operator
@@ -167,33 +272,53 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        Matrix<T> result( 0.0, this->Height(), other.Width() );
+        Matrix<T> result( this->Height(), other.Width() );
+        Apply(other, result, Workspace::Local());
+
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \param in Signal, contiguous
+     *  \param out Result, contiguous and not overlapping in, overwritten
+     *  \param workspace Scratch memory, unused
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        (void) workspace;
+#ifdef DO_ARGCHECKS
+        if( in.Height() != this->width_ || out.Height() != this->height_ || in.Width() != out.Width() )
+            throw std::invalid_argument("Views of Apply do not match the operator dimensions!");
+#endif // DO_ARGCHECKS
 
+        const Matrix<T> signal = in.Borrow();
+        Matrix<T> result = out.Borrow();
         if(!this->transposed_)
-            Forward(other, result);
+            Forward(signal, result);
         else
-            Transposed(other, result);
-
-        return result;
+            Transposed(signal, result);
     }
 
     /** Transpose in-place
+     *   \brief The compressed matrix does not move, the products pick the transposed kernel
      *   \return A reference to this
      */
     AbelTransform& Transpose() override final
     {
         std::swap(this->height_, this->width_);
-        this->data_ = std::move(this->data_.Transpose());
         this->transposed_ = !this->transposed_;
         return *this;
     }
 
     /** Generate a compressed Abel matrix
-     *  \brief Builds an Abel transform matrix with diagonal radius, without duplicating data or inserting zeros
-     *  \param result Resulting matrix of size pixel_amount/4 * wavelets_amount/2.
+     *  \brief Builds an Abel transform matrix with diagonal radius, without duplicating data or inserting zeros.
+     *  The geometry is computed first, then unless the elements are computed on the fly, a first pass finds the length
+     *  of the non-zero prefix of every row and a second one fills them.
      *  \param radius Amount of pixels from centre to border of galaxy, typically pixel_amount/2
+     *  \param storage Precision of the stored elements
+     *  \return The packed rows of the matrix of size pixel_amount/4 * wavelets_amount/2.
      */
-    void Generate(Matrix<T>& result, unsigned int radius ) const
+    Packed Generate(unsigned int radius, AbelStorage storage) const
     {
         size_t pic_side_half = pic_side_/2;
         size_t pic_side_extended = std::floor(pic_side_half*std::sqrt(2.0L));
@@ -202,144 +327,386 @@ public:
         T radius_extended_to_pic_side_extended_ratio = radius_extended/(T)pic_side_extended;
         T radius_to_pic_side_ratio = radius/(T)pic_side_half;
         T radius_extended_to_wavelet_amount_half_ratio = radius_extended/(T)wavelet_amount_half;
-        T* x_axis = new T[wavelet_amount_half];
+
+        Packed result;
+        result.width = wavelet_amount_half;
+        result.storage = storage;
+        result.x_axis.resize(wavelet_amount_half);
+        result.y_axis.resize(pic_side_half);
+        result.z_axis.resize(pic_side_half);
         #pragma omp parallel for simd
         for( size_t i = 0; i < wavelet_amount_half; ++i )
-            x_axis[i] = ((T)i+1.0L) * radius_extended_to_wavelet_amount_half_ratio;
+            result.x_axis[i] = ((T)i+1.0L) * radius_extended_to_wavelet_amount_half_ratio;
         #pragma omp parallel for simd
         for( size_t i = 0; i < pic_side_half; ++i )
         {
-            T z = (T)i * radius_to_pic_side_ratio;
-            for( size_t j = 0; j < pic_side_half; ++j )
+            result.y_axis[i] = (T)i * radius_extended_to_pic_side_extended_ratio;
+            result.z_axis[i] = (T)i * radius_to_pic_side_ratio;
+        }
+        if( storage == abel_on_the_fly )
+            return result;
+
+        const size_t rows = result.Rows();
+        result.row_start.assign(rows + 1, 0);
+        #pragma omp parallel for
+        for( size_t row = 0; row < rows; ++row )
+            result.row_start[row+1] = GenerateRow(result, row, 0, 0, nullptr);
+        std::partial_sum(result.row_start.begin(), result.row_start.end(), result.row_start.begin());
+
+        auto fill = [&](auto& values)
+        {
+            using S = typename std::decay_t<decltype(values)>::value_type;
+            values.resize(result.row_start.back());
+            #pragma omp parallel
             {
-                T y = (T)j * radius_extended_to_pic_side_extended_ratio;
-                T s = std::sqrt(y*y + z*z);
-                for(unsigned int k = 0; k < wavelet_amount_half; ++k)
+                std::vector<T> coefficients(wavelet_amount_half);
+                #pragma omp for schedule(dynamic, 16)
+                for( size_t row = 0; row < rows; ++row )
                 {
-                    if( x_axis[k] <= s )
-                        continue;
+                    size_t length = GenerateRow(result, row, 0, wavelet_amount_half, coefficients.data());
+                    for( size_t position = 0; position < length; ++position )
+                        values[result.row_start[row] + position] = (S) coefficients[position];
+                }
+            }
+        };
+        if( storage == abel_single )
+            fill(result.values_single);
+        else if( storage == abel_bfloat16 )
+            fill(result.values_bfloat16);
+        else
+            fill(result.values_full);
 
-                    T ri0 = s;
-                    if( k != 0 && x_axis[k-1] >= s )
-                        ri0 = x_axis[k-1];
+        return result;
+    }
 
-                    T ri1 = x_axis[k];
-                    if( x_axis[k] < s )
-                        ri1 = s;
+    /** Generate a row of the compressed Abel matrix
+     *  \brief The elements are the chord lengths 2(sqrt(ri1^2-s^2) - sqrt(ri0^2-s^2)) through the shells of a pixel at
+     *  distance s from the centre, non-zero where x_axis[k] > s, which stored in reverse order is a prefix of the row.
+     *  \param table Geometry of the compressed Abel matrix
+     *  \param row Row of the compressed Abel matrix
+     *  \param begin First element to compute
+     *  \param end Element after the last one to compute, the elements past the prefix are not written
+     *  \param coefficients Row of at least end elements
+     *  \return The length of the non-zero prefix of the row
+     */
+    static size_t GenerateRow(const Packed& table, size_t row, size_t begin, size_t end, T* coefficients)
+    {
+        const size_t pic_side_half = table.y_axis.size();
+        const size_t wavelet_amount_half = table.width;
+        const T* x_axis = table.x_axis.data();
+        const T z = table.z_axis[wavelet_amount_half - row/pic_side_half - 1];
+        const T y = table.y_axis[pic_side_half - row%pic_side_half - 1];
+        const T s = std::sqrt(y*y + z*z);
+        const size_t first = std::upper_bound(x_axis, x_axis + wavelet_amount_half, s) - x_axis;
+        const size_t length = wavelet_amount_half - first;
+        const size_t stop = std::min(end, length);
+
+        // the squares differences are non-negative, up to the rounding of s
+        #pragma omp simd
+        for( size_t position = begin; position < stop; ++position )
+        {
+            const size_t k = wavelet_amount_half - position - 1;
+            const T ri1 = x_axis[k];
+            const T ri0 = k > first ? x_axis[k-1] : s;
+            coefficients[position] = (T)2 * (std::sqrt(std::max(ri1*ri1 - s*s, (T)0)) - std::sqrt(std::max(ri0*ri0 - s*s, (T)0)));
+        }
+        return length;
+    }
 
-                    size_t index = (wavelet_amount_half-i-1)*pic_side_half*wavelet_amount_half + (pic_side_half-j-1)*wavelet_amount_half + wavelet_amount_half-k-1;
-                    result[index] = 2.0L*(std::sqrt(ri1*ri1 - s*s) - std::sqrt(ri0*ri0 - s*s));
-                }
-            }
+    /** Pack a compressed Abel matrix
+     *  \param data Dense compressed Abel matrix, every row is stored up to its last non-zero element
+     *  \return The packed rows of data in the precision of the operator
+     */
+    static Packed Pack(const Matrix<T>& data)
+    {
+        Packed result;
+        result.width = data.Width();
+        result.row_start.assign(data.Height() + 1, 0);
+        for( size_t row = 0; row < data.Height(); ++row )
+        {
+            size_t length = data.Width();
+            while( length != 0 && data[row*data.Width() + length - 1] == (T)0 )
+                --length;
+            result.row_start[row+1] = result.row_start[row] + length;
+            result.values_full.insert(result.values_full.end(), data.Data() + row*data.Width(), data.Data() + row*data.Width() + length);
         }
-        delete[] x_axis;
+        return result;
     }
 
     /** Abel transform
-     *  \brief Applies an Abel transform from the compressed Abel matrix.
+     *  \brief Applies an Abel transform from the compressed Abel matrix, in the precision it is stored in or computing its rows.
      *  \param signal Signal to apply the Abel transform to. Currently only accepts double type matrix
-     *  \param result Resulting matrix of size pixel_amount * wavelets_amount.
+     *  \param result Resulting matrix of size pixel_amount * wavelets_amount, overwritten.
      */
     void Forward(const Matrix<T>& signal, Matrix<T>& result ) const
     {
-        size_t pic_side_half = pic_side_/2;
-        size_t wavelet_amount_half = wavelet_amount_/2;
+        const Packed& table = *table_;
+        if( table.storage == abel_on_the_fly )
+            ForwardRows<T, T>(Generated(table), signal, result);
+        else if( table.storage == abel_single )
+            ForwardRows<float, double>(Stored(table, table.values_single.data()), signal, result);
+        else if( table.storage == abel_bfloat16 )
+            ForwardRows<Bfloat16, double>(Stored(table, table.values_bfloat16.data()), signal, result);
+        else
+            ForwardRows<T, T>(Stored(table, table.values_full.data()), signal, result);
+    }
 
-#ifdef DEBUG
-        int progress_step = std::max(1, (int)(pic_side_half*pic_side_half)/100);
-        int step = 0;
-        std::cout << std::endl;
-#endif // DEBUG
+    /** Transposed Abel transform
+     *  \brief Applies a transposed Abel transform from the compressed Abel matrix, in the precision it is stored in or computing its rows.
+     *  \param signal Signal to apply the Abel transform to. Currently only accepts double type matrix
+     *  \param result Resulting matrix of size pixel_amount * wavelets_amount, overwritten.
+     */
+    void Transposed(const Matrix<T>& signal, Matrix<T>& result ) const
+    {
+        const Packed& table = *table_;
+        if( table.storage == abel_on_the_fly )
+            TransposedRows<T, T>(Generated(table), signal, result);
+        else if( table.storage == abel_single )
+            TransposedRows<float, double>(Stored(table, table.values_single.data()), signal, result);
+        else if( table.storage == abel_bfloat16 )
+            TransposedRows<Bfloat16, double>(Stored(table, table.values_bfloat16.data()), signal, result);
+        else
+            TransposedRows<T, T>(Stored(table, table.values_full.data()), signal, result);
+    }
 
-        // iterating over blocks
-        #pragma omp parallel for
-        for( size_t block = 0; block < pic_side_half; ++block )
+private:
+    /** Rows read from the packed elements
+     *  \param table Compressed Abel matrix
+     *  \param values Packed elements of the storage precision
+     *  \return A functor giving the row and the length of its prefix, the range and the buffer are not used
+     */
+    template<class S>
+    static auto Stored(const Packed& table, const S* values)
+    {
+        const size_t* row_start = table.row_start.data();
+        return [row_start, values](size_t row, size_t, size_t, S*, const S*& coefficients)
+        {
+            coefficients = values + row_start[row];
+            return row_start[row+1] - row_start[row];
+        };
+    }
+
+    /** Rows computed from the geometry
+     *  \param table Compressed Abel matrix
+     *  \return A functor computing the requested range of the row into the buffer, giving the length of its prefix
+     */
+    static auto Generated(const Packed& table)
+    {
+        return [&table](size_t row, size_t begin, size_t end, T* buffer, const T*& coefficients)
+        {
+            coefficients = buffer;
+            return GenerateRow(table, row, begin, end, buffer);
+        };
+    }
+
+    /** Abel transform kernel
+     *  \brief Every packed row is a dot product with the first half of a signal column and another one with its mirrored
+     *  second half, each written to two symmetric rows of the result. A single column goes through SIMD reductions,
+     *  several columns are processed by tiles whose rows are updated with SIMD while the signal tile stays in cache.
+     *  The rows are dynamically scheduled since their lengths differ.
+     *  \param rows_source Functor giving the rows of the compressed Abel matrix, see Stored and Generated
+     *  \param signal Signal to apply the Abel transform to
+     *  \param result Resulting matrix of size pixel_amount * wavelets_amount, overwritten.
+     */
+    template<class S, class A, class Rows>
+    void ForwardRows(Rows rows_source, const Matrix<T>& signal, Matrix<T>& result ) const
+    {
+        const size_t pic_side_half = pic_side_/2;
+        const size_t wavelet_amount_half = wavelet_amount_/2;
+        const size_t rows = pic_side_half*pic_side_half;
+        const size_t width = signal.Width();
+        const T* source = signal.Data();
+        T* target = result.Data();
+
+        if( width == 1 )
         {
-            // iterating over rows
-            for( size_t i = 0; i < pic_side_half; ++i )
-            {
 #ifdef DEBUG
-                if( (block*pic_side_half+i) % progress_step == 0 )
-                {
-                    std::stringstream output;
-                    output << "\r" << step++;
-                    std::cout << output.str();
-                }
+            size_t progress_step = std::max((size_t)1, rows/100);
+            int step = 0;
+            std::cout << std::endl;
 #endif // DEBUG
 
-                // iterating over matrix multiplication vectors
-                for( size_t k = 0; k < wavelet_amount_half; ++k )
+            #pragma omp parallel
+            {
+                std::vector<S> buffer(wavelet_amount_half);
+                #pragma omp for schedule(dynamic, 16)
+                for( size_t row = 0; row < rows; ++row )
                 {
-                    T abel_value = this->data_[(block*pic_side_half + i)*pic_side_half + k];
-
-                    // iterating over signal columns
-                    for( size_t j = 0; j < signal.Width(); ++j )
+#ifdef DEBUG
+                    if( row % progress_step == 0 )
                     {
+                        std::stringstream output;
+                        output << "\r" << step++;
+                        std::cout << output.str();
+                    }
+#endif // DEBUG
 
-                        // left part
-                        size_t target_left_index = k*signal.Width() + j;
-
-                        T left_temp = abel_value * signal[target_left_index];
-
-                        size_t result_left_upper_index = (block*pic_side_ + i)*signal.Width() + j;
-                        result[result_left_upper_index] += left_temp;
-
-                        size_t result_left_lower_index = (block*pic_side_ + pic_side_ - i - 1)*signal.Width() + j;
-                        result[result_left_lower_index] += left_temp;
+                    const size_t block = row / pic_side_half;
+                    const size_t i = row % pic_side_half;
+                    const S* abel_row;
+                    const size_t length = rows_source(row, 0, wavelet_amount_half, buffer.data(), abel_row);
 
+                    A left = 0;
+                    A right = 0;
+                    #pragma omp simd reduction(+:left,right)
+                    for( size_t k = 0; k < length; ++k )
+                    {
+                        left += (A) abel_row[k] * (A) source[k];
+                        right += (A) abel_row[k] * (A) source[pic_side_ - k - 1];
+                    }
 
-                        // right part
-                        size_t target_right_index = (pic_side_ - k - 1)*signal.Width() + j;
+                    target[block*pic_side_ + i] = (T) left;
+                    target[block*pic_side_ + pic_side_ - i - 1] = (T) left;
+                    target[(pic_side_ - block - 1)*pic_side_ + i] = (T) right;
+                    target[(pic_side_ - block - 1)*pic_side_ + pic_side_ - i - 1] = (T) right;
+                }
+            }
+            return;
+        }
 
-                        T right_temp = abel_value * signal[target_right_index];
+        const size_t tiles = (width + column_tile - 1) / column_tile;
 
-                        size_t result_right_upper_index = ((pic_side_ - block -1)*pic_side_ + i)*signal.Width() + j;
-                        result[result_right_upper_index] += right_temp;
+        // iterating over column tiles, then over compressed rows sharing the tile
+        #pragma omp parallel
+        {
+            std::vector<S> buffer(wavelet_amount_half);
+            #pragma omp for collapse(2) schedule(dynamic, 16)
+            for( size_t tile = 0; tile < tiles; ++tile )
+            {
+                for( size_t row = 0; row < rows; ++row )
+                {
+                    const size_t j_start = tile*column_tile;
+                    const size_t j_amount = std::min(column_tile, width - j_start);
+                    const size_t block = row / pic_side_half;
+                    const size_t i = row % pic_side_half;
+                    const S* abel_row;
+                    const size_t length = rows_source(row, 0, wavelet_amount_half, buffer.data(), abel_row);
+
+                    A left[column_tile] = {};
+                    A right[column_tile] = {};
+                    for( size_t k = 0; k < length; ++k )
+                    {
+                        const A abel_value = (A) abel_row[k];
+                        const T* left_source = source + k*width + j_start;
+                        const T* right_source = source + (pic_side_ - k - 1)*width + j_start;
+                        #pragma omp simd
+                        for( size_t j = 0; j < j_amount; ++j )
+                        {
+                            left[j] += abel_value * (A) left_source[j];
+                            right[j] += abel_value * (A) right_source[j];
+                        }
+                    }
 
-                        size_t result_right_lower_index = ((pic_side_ - block -1)*pic_side_ + pic_side_ - i - 1)*signal.Width() + j;
-                        result[result_right_lower_index] += right_temp;
+                    T* left_upper = target + (block*pic_side_ + i)*width + j_start;
+                    T* left_lower = target + (block*pic_side_ + pic_side_ - i - 1)*width + j_start;
+                    T* right_upper = target + ((pic_side_ - block - 1)*pic_side_ + i)*width + j_start;
+                    T* right_lower = target + ((pic_side_ - block - 1)*pic_side_ + pic_side_ - i - 1)*width + j_start;
+                    for( size_t j = 0; j < j_amount; ++j )
+                    {
+                        left_upper[j] = left_lower[j] = (T) left[j];
+                        right_upper[j] = right_lower[j] = (T) right[j];
                     }
                 }
             }
         }
     }
 
-    /** Transposed Abel transform
-     *  \brief Applies a transposed Abel transform from the compressed Abel matrix.
-     *  \param signal Signal to apply the Abel transform to. Currently only accepts double type matrix
-     *  \param result Resulting matrix of size pixel_amount * wavelets_amount.
+    /** Transposed Abel transform kernel
+     *  \brief The packed matrix is read in its forward layout. The result rows are split into cache line wide ranges
+     *  and the columns into tiles, every pair of them is a task streaming the matching segments of the packed rows
+     *  long enough to reach the range, so that each result element is accumulated in the same order as with a
+     *  physically transposed matrix. The tasks are dynamically scheduled since the first ranges are the longest.
+     *  \param rows_source Functor giving the rows of the compressed Abel matrix, see Stored and Generated
+     *  \param signal Signal to apply the Abel transform to
+     *  \param result Resulting matrix of size pixel_amount * wavelets_amount, overwritten.
      */
-    void Transposed(const Matrix<T>& signal, Matrix<T>& result ) const
+    template<class S, class A, class Rows>
+    void TransposedRows(Rows rows_source, const Matrix<T>& signal, Matrix<T>& result ) const
     {
-        size_t pic_side_half = pic_side_/2;
-        size_t wavelet_amount_half = wavelet_amount_/2;
-
-        // iterating over rows
-        #pragma omp parallel for
-        for( size_t i = 0; i < wavelet_amount_half; ++i )
+        const size_t pic_side_half = pic_side_/2;
+        const size_t wavelet_amount_half = wavelet_amount_/2;
+        const size_t width = signal.Width();
+        const size_t ranges = (wavelet_amount_half + row_range - 1) / row_range;
+        const size_t tiles = (width + column_tile - 1) / column_tile;
+        const T* source = signal.Data();
+        T* target = result.Data();
+
+        // iterating over column tiles and ranges of rows
+        #pragma omp parallel
         {
-
-            // iterating over blocks
-            for( size_t block = 0; block < pic_side_half; ++block )
+            std::vector<S> buffer(wavelet_amount_half);
+            #pragma omp for collapse(2) schedule(dynamic)
+            for( size_t tile = 0; tile < tiles; ++tile )
             {
-
-                // iterating over matrix multiplication vectors
-                for( size_t k = 0; k < pic_side_half; ++k )
+                for( size_t range = 0; range < ranges; ++range )
                 {
-                    T abel_value = this->data_[i*pic_side_half*pic_side_half + block*pic_side_half + k];
+                    const size_t j_start = tile*column_tile;
+                    const size_t j_amount = std::min(column_tile, width - j_start);
+                    const size_t i_start = range*row_range;
+                    const size_t i_amount = std::min(row_range, wavelet_amount_half - i_start);
+
+                    // accumulators of the task, row by row with the width of the tile
+                    A upper[row_range*column_tile];
+                    A lower[row_range*column_tile];
+                    std::fill(upper, upper + i_amount*j_amount, (A)0);
+                    std::fill(lower, lower + i_amount*j_amount, (A)0);
+
+                    // iterating over blocks
+                    for( size_t block = 0; block < pic_side_half; ++block )
+                    {
+
+                        // iterating over matrix multiplication vectors
+                        for( size_t k = 0; k < pic_side_half; ++k )
+                        {
+                            const S* coefficients;
+                            const size_t length = rows_source(block*pic_side_half + k, i_start, i_start + i_amount, buffer.data(), coefficients);
+                            if( length <= i_start )
+                                continue;
+                            const S* abel_row = coefficients + i_start;
+                            const size_t i_stop = std::min(i_amount, length - i_start);
+
+                            // source rows
+                            const T* upper_left = source + (block*pic_side_ + k)*width + j_start;
+                            const T* upper_right = source + (block*pic_side_ + pic_side_ - k - 1)*width + j_start;
+                            const T* lower_left = source + ((pic_side_ - block - 1)*pic_side_ + k)*width + j_start;
+                            const T* lower_right = source + ((pic_side_ - block - 1)*pic_side_ + pic_side_ - k - 1)*width + j_start;
+
+                            if( width == 1 )
+                            {
+                                const A upper_sum = (A) (upper_left[0] + upper_right[0]);
+                                const A lower_sum = (A) (lower_left[0] + lower_right[0]);
+                                #pragma omp simd
+                                for( size_t i = 0; i < i_stop; ++i )
+                                {
+                                    upper[i] += (A) abel_row[i] * upper_sum;
+                                    lower[i] += (A) abel_row[i] * lower_sum;
+                                }
+                                continue;
+                            }
+
+                            for( size_t i = 0; i < i_stop; ++i )
+                            {
+                                const A abel_value = (A) abel_row[i];
+                                #pragma omp simd
+                                for( size_t j = 0; j < j_amount; ++j )
+                                {
+                                    upper[i*j_amount + j] += abel_value * (A) (upper_left[j] + upper_right[j]);
+                                    lower[i*j_amount + j] += abel_value * (A) (lower_left[j] + lower_right[j]);
+                                }
+                            }
+                        }
+                    }
 
-                    // iterating over signal columns
-                    for( size_t j = 0; j < signal.Width(); ++j )
+                    // every result element belongs to a single task
+                    for( size_t i = 0; i < i_amount; ++i )
                     {
-                        // target indices
-                        size_t target_upper_left_index = (block*pic_side_ + k)*signal.Width() + j;
-                        size_t target_upper_right_index = (block*pic_side_ + pic_side_ - k - 1)*signal.Width() + j;
-                        size_t target_lower_left_index = ((pic_side_ - block - 1)*pic_side_ + k)*signal.Width() + j;
-                        size_t target_lower_right_index = ((pic_side_ - block - 1)*pic_side_ + pic_side_ - k - 1)*signal.Width() + j;
-
-                        // updating result
-                        result[i*signal.Width() + j] += abel_value * (signal[target_upper_left_index] + signal[target_upper_right_index]);
-                        result[(wavelet_amount_ - i - 1)*signal.Width() + j] += abel_value * (signal[target_lower_left_index] + signal[target_lower_right_index]);
+                        T* upper_target = target + (i_start + i)*width + j_start;
+                        T* lower_target = target + (wavelet_amount_ - i_start - i - 1)*width + j_start;
+                        for( size_t j = 0; j < j_amount; ++j )
+                        {
+                            upper_target[j] = (T) upper[i*j_amount + j];
+                            lower_target[j] = (T) lower[i*j_amount + j];
+                        }
                     }
                 }
             }
@@ -10,6 +10,8 @@
 #ifndef ASTROQUT_UTILS_OPERATOR_ASTROOPERATOR_HPP
 #define ASTROQUT_UTILS_OPERATOR_ASTROOPERATOR_HPP
 
+#include "utils/linearop/matrix/view.hpp"
+#include "utils/linearop/operator/abelspline.hpp"
 #include "utils/linearop/operator/abeltransform.hpp"
 #include "utils/linearop/operator/blurring.hpp"
 #include "utils/linearop/operator/matmult/spline.hpp"
@@ -26,10 +28,21 @@ private:
     size_t pic_size_;
     AbelTransform<T> abel_;
     Blurring<T> blurring_;
-    Matrix<T> sensitivity_;
-    Matrix<T> standardize_;
+    Shared<Matrix<T>> sensitivity_;
+    Shared<Matrix<T>> standardize_;
     Spline<T> spline_;
     Wavelet<T> wavelet_;
+    AbelSpline<T> abel_spline_; //!< Member variable "abel_spline_" product of abel_ and spline_, empty unless precomposed
+
+    /** Compose abel_ and spline_
+     *  \brief Keeps the orientation of this operator
+     */
+    void Precompose()
+    {
+        abel_spline_ = this->transposed_ ?
+                       AbelSpline<T>(abel_, spline_).Transpose() :
+                       AbelSpline<T>(abel_, spline_);
+    }
 
 public:
     /** Default constructor
@@ -43,6 +56,7 @@ public:
         , standardize_()
         , spline_()
         , wavelet_()
+        , abel_spline_()
     {
 #ifdef DEBUG
         std::cout << "AstroOperator : Default constructor called" << std::endl;
@@ -50,6 +64,7 @@ public:
     }
 
     /** Copy constructor
+     *  \brief The tables of the sub-operators and the vectors are shared with other, not copied
      *  \param other Object to copy from
      */
     AstroOperator(const AstroOperator& other)
@@ -61,6 +76,7 @@ public:
         , standardize_(other.standardize_)
         , spline_(other.spline_)
         , wavelet_(other.wavelet_)
+        , abel_spline_(other.abel_spline_)
     {
 #ifdef DEBUG
         std::cout << "AstroOperator : Copy constructor called" << std::endl;
@@ -102,9 +118,9 @@ public:
                       transposed)
         , pic_size_(pic_size)
         , abel_(transposed ?
-                AbelTransform<T>(wavelet_amount, pic_size*pic_size, radius).Transpose() :
-                AbelTransform<T>(wavelet_amount, pic_size*pic_size, radius))
-        , blurring_(Blurring<T>(params.blurring_filter, pic_size))
+                AbelTransform<T>(wavelet_amount, pic_size*pic_size, radius, params.abel_storage).Transpose() :
+                AbelTransform<T>(wavelet_amount, pic_size*pic_size, radius, params.abel_storage))
+        , blurring_(Blurring<T>(params.blurring_filter, pic_size, params.blurring_backend, params.blurring_tolerance))
         , sensitivity_(sensitivity)
         , standardize_(standardize)
         , spline_(transposed ?
@@ -113,10 +129,13 @@ public:
         , wavelet_(transposed ?
                    Wavelet<T>((WaveletType) params.wavelet[0], params.wavelet[1]).Transpose() :
                    Wavelet<T>((WaveletType) params.wavelet[0], params.wavelet[1]))
+        , abel_spline_()
     {
 #ifdef DEBUG
         std::cout << "AstroOperator : Build constructor called" << std::endl;
 #endif // DEBUG
+        if( params.precompose_spline )
+            Precompose();
     }
 
     /** Full member constructor
@@ -148,6 +167,7 @@ public:
         , standardize_(standardize)
         , spline_( transposed ? spline : spline.Transpose() )
         , wavelet_( transposed ? wavelet : wavelet.Transpose() )
+        , abel_spline_()
     {
 #ifdef DEBUG
         std::cout << "AstroOperator : Full member constructor called" << std::endl;
@@ -184,9 +204,15 @@ public:
     {
         return abel_;
     }
+    /** Set abel_
+     *  \brief Composes the new transform with the spline operator again if it was precomposed
+     *  \param abel New value to set
+     */
     void Abel(const AbelTransform<T> abel)
     {
         abel_ = abel;
+        if( !abel_spline_.IsEmpty() )
+            Precompose();
     }
 
     Blurring<T> Blur() const
@@ -198,19 +224,23 @@ public:
         blurring_ = blurring;
     }
 
-    Matrix<T> Sensitivity() const
+    const Matrix<T>& Sensitivity() const
     {
-        return sensitivity_;
+        return *sensitivity_;
     }
     void Sensitivity(const Matrix<T> sensitivity)
     {
         sensitivity_ = sensitivity;
     }
 
-    Matrix<T> Standardize() const
+    const Matrix<T>& Standardize() const
     {
-        return standardize_;
+        return *standardize_;
     }
+    /** Set standardize_
+     *  \brief The copies of this operator keep the previous vector
+     *  \param standardize New value to set
+     */
     void Standardize(const Matrix<T> standardize)
     {
         standardize_ = standardize;
@@ -220,9 +250,23 @@ public:
     {
         return spline_;
     }
+    /** Set spline_
+     *  \brief Composes the Abel transform with the new operator again if it was precomposed
+     *  \param spline New value to set
+     */
     void SplineOp(const Spline<T> spline)
     {
         spline_ = spline;
+        if( !abel_spline_.IsEmpty() )
+            Precompose();
+    }
+
+    /** Precomposition test
+     *  \return True if the spline part goes through the product of the Abel transform and the spline operator
+     */
+    bool IsPrecomposed() const noexcept
+    {
+        return !abel_spline_.IsEmpty();
     }
 
     Wavelet<T> WaveletOp() const
@@ -241,9 +285,11 @@ public:
     {
         this->transposed_ = !this->transposed_;
         std::swap(this->height_, this->width_);
-        abel_ = abel_.Transpose();
-        spline_ = spline_.Transpose();
-        wavelet_ = wavelet_.Transpose();
+        abel_.Transpose();
+        spline_.Transpose();
+        wavelet_.Transpose();
+        if( !abel_spline_.IsEmpty() )
+            abel_spline_.Transpose();
         return *this;
     }
 
@@ -263,6 +309,7 @@ public:
         swap(first.standardize_, second.standardize_);
         swap(first.spline_, second.spline_);
         swap(first.wavelet_, second.wavelet_);
+        swap(first.abel_spline_, second.abel_spline_);
     }
 
     /** Copy assignment operator
@@ -300,12 +347,47 @@ public:
         return result;
     }
 
-    Matrix<T> BAW(const Matrix<T> source,
+    /** Out-of-place application
+     *  \param in Model or picture vector
+     *  \param out Picture or model vector, contiguous and not overlapping in
+     *  \param workspace Scratch memory for the intermediate results, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        if(!this->transposed_)
+            BAW(in, out, workspace);
+        else
+            WtAtBt(in, out, workspace);
+    }
+
+    Matrix<T> BAW(const Matrix<T>& source,
                   bool standardize = true,
                   bool apply_wavelet = true,
                   bool apply_spline = true,
                   bool ps = true ) const
     {
+        Matrix<T> result(pic_size_*pic_size_, 1);
+        BAW(source, result, Workspace::Local(), standardize, apply_wavelet, apply_spline, ps);
+        return result;
+    }
+
+    /** B * A * W in-place
+     *  \param source Model vector, wavelet and spline coefficients followed by the point sources if ps
+     *  \param result Picture vector, contiguous and not overlapping source
+     *  \param workspace Scratch memory for the intermediate results, left as it was found
+     *  \param standardize Divide the source by the standardization vector first
+     *  \param apply_wavelet Use the wavelet coefficients
+     *  \param apply_spline Use the spline coefficients
+     *  \param ps Add the point sources
+     */
+    void BAW(const MatrixView<T>& source,
+             MatrixView<T> result,
+             Workspace& workspace,
+             bool standardize = true,
+             bool apply_wavelet = true,
+             bool apply_spline = true,
+             bool ps = true ) const
+    {
 #ifdef DEBUG
         std::cerr << "BAW called" << std::endl;
 #endif // DEBUG
@@ -315,63 +397,128 @@ public:
             std::cerr << "You shall not use BAW on transposed operator!" << std::endl;
             throw;
         }
+        if( result.Length() != pic_size_*pic_size_ || !result.IsContiguous() )
+            throw std::invalid_argument("Result of BAW must be a contiguous picture vector!");
 #endif // DO_ARGCHECKS
+        Workspace::Frame frame(workspace);
 
-        Matrix<T> normalized_source = source;
-        if(standardize)
-            normalized_source /= standardize_;
+        MatrixView<T> normalized_source = source;
+        if( standardize && !standardize_->IsEmpty() )
+        {
+            const T* standardize_data = standardize_->Data();
+            normalized_source = MatrixView<T>(workspace.Allocate<T>(source.Length()), source.Height(), source.Width());
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < source.Length(); ++i)
+                normalized_source[i] = source[i] / standardize_data[i];
+        }
+
+        // the spline coefficients skip the Abel transform below if it was composed with the spline operator
+        const bool precomposed = apply_spline && !abel_spline_.IsEmpty();
 
         // W * xw
-        Matrix<T> result_wavelet;
+        MatrixView<T> result_wavelet(workspace.Allocate<T>(pic_size_), pic_size_, 1);
         if( apply_wavelet )
         {
-            Matrix<T> source_wavelet(&normalized_source[0], pic_size_, 1);
-            result_wavelet = wavelet_ * source_wavelet;
-            source_wavelet.Data(nullptr);
+            wavelet_.Apply(normalized_source.Segment(0, pic_size_), result_wavelet, workspace);
         }
 
         // W * xs
-        Matrix<T> result_spline;
-        if( apply_spline )
+        if( apply_spline && !precomposed )
         {
-            Matrix<T> source_spline(&normalized_source[pic_size_], pic_size_, 1);
-            result_spline = spline_ * source_spline;
-            source_spline.Data(nullptr);
+            MatrixView<T> result_spline(workspace.Allocate<T>(pic_size_), pic_size_, 1);
+            spline_.Apply(normalized_source.Segment(pic_size_, pic_size_), result_spline, workspace);
+            if( apply_wavelet )
+            {
+                #pragma omp parallel for simd
+                for(size_t i = 0; i < pic_size_; ++i)
+                    result_wavelet[i] += result_spline[i];
+            }
+            else
+            {
+                std::copy(result_spline.Data(), result_spline.Data() + pic_size_, result_wavelet.Data());
+            }
+        }
+        else if( !apply_wavelet && !precomposed )
+        {
+            std::fill(result_wavelet.Data(), result_wavelet.Data() + pic_size_, (T)0);
         }
 
         // A * (Wxw + Wxs)
-        Matrix<T> result = abel_ * (result_wavelet + result_spline);
-        result.Height(pic_size_);
-        result.Width(pic_size_);
+        MatrixView<T> AWx(workspace.Allocate<T>(pic_size_*pic_size_), pic_size_, pic_size_);
+        MatrixView<T> AWx_vector(AWx.Data(), pic_size_*pic_size_, 1);
+        if( apply_wavelet || !precomposed )
+        {
+            abel_.Apply(result_wavelet, AWx_vector, workspace);
+        }
+
+        // (A * S) * xs
+        if( precomposed && apply_wavelet )
+        {
+            MatrixView<T> ASx(workspace.Allocate<T>(pic_size_*pic_size_), pic_size_*pic_size_, 1);
+            abel_spline_.Apply(normalized_source.Segment(pic_size_, pic_size_), ASx, workspace);
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < pic_size_*pic_size_; ++i)
+                AWx[i] += ASx[i];
+        }
+        else if( precomposed )
+        {
+            abel_spline_.Apply(normalized_source.Segment(pic_size_, pic_size_), AWx_vector, workspace);
+        }
 
         // AWx + ps
         if( ps )
         {
-            Matrix<T> source_ps(&normalized_source[2*pic_size_], pic_size_, pic_size_);
-            result += source_ps;
-            source_ps.Data(nullptr);
+            const T* point_sources = normalized_source.Data() + 2*pic_size_;
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < pic_size_*pic_size_; ++i)
+                AWx[i] += point_sources[i];
         }
 
         // B(AWx + ps)
-        result = blurring_ * result;
-        result.Height(pic_size_*pic_size_);
-        result.Width(1);
+        blurring_.Apply(AWx, MatrixView<T>(result.Data(), pic_size_, pic_size_), workspace);
 
         // E' .* B(AWx + ps)
-        result = result & sensitivity_;
+        if( !sensitivity_->IsEmpty() )
+        {
+            const T* sensitivity = sensitivity_->Data();
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < pic_size_*pic_size_; ++i)
+                result[i] *= sensitivity[i];
+        }
 
 #ifdef DEBUG
         std::cerr << "BAW done" << std::endl;
 #endif // DEBUG
-        return result;
     }
 
-    Matrix<T> WtAtBt(const Matrix<T> source,
+    Matrix<T> WtAtBt(const Matrix<T>& source,
                      bool standardize = true,
                      bool apply_wavelet = true,
                      bool apply_spline = true,
                      bool ps = true ) const
     {
+        Matrix<T> result((apply_wavelet + apply_spline + ps*pic_size_)*pic_size_, 1);
+        WtAtBt(source, result, Workspace::Local(), standardize, apply_wavelet, apply_spline, ps);
+        return result;
+    }
+
+    /** W' * A' * B' in-place
+     *  \param source Picture vector
+     *  \param result Model vector of (apply_wavelet + apply_spline + ps*pic_size)*pic_size elements, contiguous and not overlapping source
+     *  \param workspace Scratch memory for the intermediate results, left as it was found
+     *  \param standardize Divide the result by the standardization vector
+     *  \param apply_wavelet Compute the wavelet coefficients
+     *  \param apply_spline Compute the spline coefficients
+     *  \param ps Compute the point sources
+     */
+    void WtAtBt(const MatrixView<T>& source,
+                MatrixView<T> result,
+                Workspace& workspace,
+                bool standardize = true,
+                bool apply_wavelet = true,
+                bool apply_spline = true,
+                bool ps = true ) const
+    {
 #ifdef DEBUG
         std::cerr << "WtAtBt called" << std::endl;
 #endif // DEBUG
@@ -381,55 +528,69 @@ public:
             std::cerr << "You shall not use WtAtBt on a not transposed operator!" << std::endl;
             throw;
         }
+        if( result.Length() != (apply_wavelet + apply_spline + ps*pic_size_)*pic_size_ || !result.IsContiguous() )
+            throw std::invalid_argument("Result of WtAtBt does not match the requested parts!");
 #endif // DO_ARGCHECKS
-        // result matrix
-        Matrix<T> result((apply_wavelet + apply_spline + ps*pic_size_)*pic_size_, 1);
+        Workspace::Frame frame(workspace);
 
         // E' .* x
-        Matrix<T> BEtx = source & sensitivity_;
-        BEtx.Height(pic_size_);
-        BEtx.Width(pic_size_);
-
-        // B * Etx
-        BEtx = blurring_ * BEtx;
-        BEtx.Height(pic_size_*pic_size_);
-        BEtx.Width(1);
-
-        if( ps )
+        MatrixView<T> Etx(workspace.Allocate<T>(pic_size_*pic_size_), pic_size_, pic_size_);
+        if( sensitivity_->IsEmpty() )
         {
+            std::copy(source.Data(), source.Data() + pic_size_*pic_size_, Etx.Data());
+        }
+        else
+        {
+            const T* sensitivity = sensitivity_->Data();
             #pragma omp parallel for simd
             for(size_t i = 0; i < pic_size_*pic_size_; ++i)
-                result[(apply_wavelet + apply_spline)*pic_size_ + i] = BEtx[i];
+                Etx[i] = source[i] * sensitivity[i];
         }
 
+        // B * Etx, directly in the point sources part of the result if they are requested
+        MatrixView<T> BEtx(ps ? result.Data() + (apply_wavelet + apply_spline)*pic_size_ : workspace.Allocate<T>(pic_size_*pic_size_), pic_size_, pic_size_);
+        blurring_.Apply(Etx, BEtx, workspace);
+
+        // the spline coefficients skip the Abel transform if it was composed with the spline operator
+        const bool precomposed = apply_spline && !abel_spline_.IsEmpty();
+
         // A' * BEtx
-        Matrix<T> AtBEtx = abel_ * BEtx;
+        MatrixView<T> BEtx_vector(BEtx.Data(), pic_size_*pic_size_, 1);
+        MatrixView<T> AtBEtx(workspace.Allocate<T>(pic_size_), pic_size_, 1);
+        if( apply_wavelet || (apply_spline && !precomposed) )
+        {
+            abel_.Apply(BEtx_vector, AtBEtx, workspace);
+        }
 
         // W' * AtBEtx
         if( apply_wavelet )
         {
-            Matrix<T> result_wavelet = wavelet_ * AtBEtx;
-            #pragma omp parallel for simd
-            for(size_t i = 0; i < pic_size_; ++i)
-                result[i] = result_wavelet[i];
+            wavelet_.Apply(AtBEtx, result.Segment(0, pic_size_), workspace);
         }
 
         // S' * AtBEtx
-        if( apply_spline )
+        if( apply_spline && !precomposed )
         {
-            Matrix<T> result_spline = spline_ * AtBEtx;
-            #pragma omp parallel for simd
-            for(size_t i = 0; i < pic_size_; ++i)
-                result[apply_wavelet*pic_size_ + i] = result_spline[i];
+            spline_.Apply(AtBEtx, result.Segment(apply_wavelet*pic_size_, pic_size_), workspace);
+        }
+
+        // (A * S)' * BEtx
+        if( precomposed )
+        {
+            abel_spline_.Apply(BEtx_vector, result.Segment(apply_wavelet*pic_size_, pic_size_), workspace);
         }
 
         // standardize
-        if(standardize)
-            result /= standardize_;
+        if( standardize && !standardize_->IsEmpty() )
+        {
+            const T* standardize_data = standardize_->Data();
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < result.Length(); ++i)
+                result[i] /= standardize_data[i];
+        }
 #ifdef DEBUG
         std::cerr << "WtAtBt done" << std::endl;
 #endif // DEBUG
-        return result;
     }
 };
 
@@ -10,27 +10,50 @@
 #ifndef ASTROQUT_UTILS_OPERATOR_BLUR_HPP
 #define ASTROQUT_UTILS_OPERATOR_BLUR_HPP
 
-#ifdef BLURRING_CONVOLUTION
 #include "utils/linearop/operator/convolution.hpp"
-#else
 #include "utils/linearop/operator/fourier.hpp"
-#endif // BLURRING_CONVOLUTION
+#include "utils/linearop/operator/separableconvolution.hpp"
 
+#include <chrono>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace alias
 {
 
+/** Backends of the blurring operator
+ */
+enum BlurringBackend {blurring_auto,        //!< fastest backend measured once per picture size, filter size and thread count
+                      blurring_convolution, //!< direct convolution in the picture domain
+                      blurring_fourier,     //!< product of the spectra of the zero-padded picture and filter
+                      blurring_separable};  //!< direct convolution with a sum of separable filters approximating the filter, never measured
+
 template<class T = double>
 class Blurring : public Operator<T>
 {
 public:
-#ifdef BLURRING_CONVOLUTION
+    BlurringBackend backend_;
     Convolution<T> convolution_;
-#else
+    SeparableConvolution<T> separable_;
     size_t filter_size_;
     Fourier<T> fourier_;
-    Matrix<std::complex<T>> filter_freq_domain_;
-#endif // BLURRING_CONVOLUTION
+    Shared<Matrix<std::complex<T>>> filter_freq_domain_;
+
+private:
+    /** Backends chosen by Tune, indexed by picture size, filter size and thread count
+     */
+    static std::map<std::tuple<size_t, size_t, size_t>, BlurringBackend>& Choices()
+    {
+        static std::map<std::tuple<size_t, size_t, size_t>, BlurringBackend> choices;
+        return choices;
+    }
+    static std::mutex& ChoicesMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
 
 public:
 
@@ -38,13 +61,12 @@ public:
      */
     Blurring()
         : Operator<T>()
-#ifdef BLURRING_CONVOLUTION
+        , backend_(blurring_convolution)
         , convolution_()
-#else
+        , separable_()
         , filter_size_(0)
         , fourier_()
         , filter_freq_domain_()
-#endif // BLURRING_CONVOLUTION
     {
 #ifdef DEBUG
         std::cout << "Blurring : Default constructor called" << std::endl;
@@ -56,13 +78,12 @@ public:
      */
     Blurring(const Blurring& other)
         : Operator<T>(other)
-#ifdef BLURRING_CONVOLUTION
+        , backend_(other.backend_)
         , convolution_(other.convolution_)
-#else
+        , separable_(other.separable_)
         , filter_size_(other.filter_size_)
         , fourier_(other.fourier_)
         , filter_freq_domain_(other.filter_freq_domain_)
-#endif // BLURRING_CONVOLUTION
     {
 #ifdef DEBUG
         std::cout << "Blurring : Copy constructor called" << std::endl;
@@ -86,79 +107,90 @@ public:
      *  \param R0 Core radius of the PSF
      *  \param alpha Decrease speed of the PSF
      *  \param pic_size Size of the picture the operator is acting on
+     *  \param backend Backend of the operator, measured if blurring_auto
+     *  \param tolerance Relative error allowed on the filter by blurring_separable
      */
-    explicit Blurring(T threshold, T R0, T alpha, size_t pic_size)
-        : Operator<T>(pic_size, pic_size)
-#ifdef BLURRING_CONVOLUTION
-        , convolution_(Generate(threshold, R0, alpha))
-#else
-        , filter_size_(0)
-        , fourier_()
-        , filter_freq_domain_()
-#endif // BLURRING_CONVOLUTION
+    explicit Blurring(T threshold, T R0, T alpha, size_t pic_size, BlurringBackend backend = blurring_auto, double tolerance = 0)
+        : Blurring()
     {
 #ifdef DEBUG
         std::cout << "Blurring : Generate constructor called with threshold=" << threshold << ", R0=" << R0 << ", alpha=" << alpha << ", pic_size=" << pic_size << std::endl;
 #endif // DEBUG
 
-#ifndef BLURRING_CONVOLUTION
         Matrix<T> filter = Generate(threshold, R0, alpha);
 
-        *this = Blurring(filter, pic_size);
-#endif // BLURRING_CONVOLUTION
+        *this = Blurring(filter, pic_size, backend, tolerance);
     }
 
     /** Full member constructor
+     *  \brief Only the state of the chosen backend is built
      *  \param data Blurring filter matrix
      *  \param pic_size Size of the picture the operator is acting on
+     *  \param backend Backend of the operator, measured if blurring_auto
+     *  \param tolerance Relative error allowed on the filter by blurring_separable
      */
-    explicit Blurring(const Matrix<T>& filter, size_t pic_size)
+    explicit Blurring(const Matrix<T>& filter, size_t pic_size, BlurringBackend backend = blurring_auto, double tolerance = 0)
         : Operator<T>(pic_size, pic_size)
-#ifdef BLURRING_CONVOLUTION
-        , convolution_(filter)
-#else
+        , backend_(backend == blurring_auto ? Tune(filter, pic_size) : backend)
+        , convolution_()
+        , separable_()
         , filter_size_(filter.Width())
-        , fourier_(std::pow(2,std::ceil(std::log2(pic_size + filter_size_ - 1))))
+        , fourier_()
         , filter_freq_domain_()
-#endif // BLURRING_CONVOLUTION
     {
 #ifdef DEBUG
-        std::cout << "Blurring : Full member constructor called with filter=" << &filter << ", pic_size=" << pic_size << std::endl;
+        std::cout << "Blurring : Full member constructor called with filter=" << &filter << ", pic_size=" << pic_size << ", backend=" << backend_ << std::endl;
 #endif // DEBUG
 
-#ifndef BLURRING_CONVOLUTION
-        filter_freq_domain_ = fourier_.FFT2D(filter);
-#endif // BLURRING_CONVOLUTION
+        if( backend_ == blurring_convolution )
+        {
+            convolution_ = Convolution<T>(filter);
+        }
+        else if( backend_ == blurring_separable )
+        {
+            separable_ = SeparableConvolution<T>(filter, tolerance);
+        }
+        else
+        {
+            fourier_ = Fourier<T>(std::pow(2,std::ceil(std::log2(pic_size + filter_size_ - 1))));
+
+            // the spectra multiply to a convolution, the filter is turned by half a turn to correlate as the direct backend
+            Matrix<T> rotated_filter(filter.Height(), filter.Width());
+            for(size_t i = 0; i < filter.Length(); ++i)
+                rotated_filter[i] = filter[filter.Length() - i - 1];
+
+            // the normalization of the inverse transform is folded into the filter
+            const size_t length = fourier_.Width();
+            Matrix<std::complex<T>> filter_freq_domain(fourier_.HalfWidth(), length);
+            fourier_.RealFFT2D(rotated_filter, filter_freq_domain.Data(), Workspace::Local());
+            filter_freq_domain *= std::complex<T>((T)1 / ((T)length*length));
+            filter_freq_domain_ = std::move(filter_freq_domain);
+        }
     }
 
     /** File constructor
      *  \brief Loads the blurring filter from a file
      *  \param path Path to the blurring filter
      *  \param pic_size Width of the target picture
+     *  \param backend Backend of the operator, measured if blurring_auto
+     *  \param tolerance Relative error allowed on the filter by blurring_separable
      */
-    explicit Blurring(const std::string& path, size_t pic_size)
-        : Operator<T>(pic_size, pic_size)
-#ifdef BLURRING_CONVOLUTION
-        , convolution_()
-#else
-        , filter_size_(0)
-        , fourier_()
-        , filter_freq_domain_()
-#endif // BLURRING_CONVOLUTION
+    explicit Blurring(const std::string& path, size_t pic_size, BlurringBackend backend = blurring_auto, double tolerance = 0)
+        : Blurring()
     {
 #ifdef DEBUG
         std::cout << "Blurring : File constructor called with path=" << path << ", pic_size=" << pic_size << std::endl;
 #endif // DEBUG
 
-        // load raw data from file
-        Matrix<T> filter(path);
+        // load raw data from file, headerless filters hold double precision data
+        Matrix<T> filter(path, (double) 0);
 
         // determine the filter's size
         size_t filter_size = std::sqrt(filter.Length());
         filter.Height(filter_size);
         filter.Width(filter_size);
 
-        *this = Blurring(filter, pic_size);
+        *this = Blurring(filter, pic_size, backend, tolerance);
     }
 
     /** Clone function
@@ -184,13 +216,9 @@ public:
     bool IsValid() const override final
     {
         if( this->height_ != 0 && this->width_ != 0 &&
-#ifdef BLURRING_CONVOLUTION
-            convolution_.IsValid() )
-#else
-            filter_size_ != 0 &&
-            fourier_.IsValid() &&
-            filter_freq_domain_.IsValid() )
-#endif // BLURRING_CONVOLUTION
+            (backend_ == blurring_convolution ? convolution_.IsValid() :
+             backend_ == blurring_separable ? separable_.IsValid() :
+             filter_size_ != 0 && fourier_.IsValid() && filter_freq_domain_->IsValid()) )
             return true;
 
         throw std::invalid_argument("Blurring dimensions must be non-zero and members shall be valid!");
@@ -233,14 +261,12 @@ public:
         using std::swap;
 
         swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
-
-#ifdef BLURRING_CONVOLUTION
+        swap(first.backend_, second.backend_);
         swap(first.convolution_, second.convolution_);
-#else
+        swap(first.separable_, second.separable_);
         swap(first.filter_size_, second.filter_size_);
         swap(first.fourier_, second.fourier_);
         swap(first.filter_freq_domain_, second.filter_freq_domain_);
-#endif // BLURRING_CONVOLUTION
     }
 
     /** Copy assignment operator
@@ -266,22 +292,100 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-#ifdef BLURRING_CONVOLUTION
-        return convolution_ * other;
-#else
-        Matrix<std::complex<T>> other_freq_domain = fourier_.FFT2D(other);
-        Matrix<std::complex<T>> full_result = fourier_.IFFT2D( filter_freq_domain_ & other_freq_domain );
         Matrix<T> result(other.Height(), other.Width());
+        Apply(other, result, Workspace::Local());
+
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \param in Picture to blur
+     *  \param out Result of the same size as in, not overlapping in
+     *  \param workspace Scratch memory for the frequency domain, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        if( backend_ == blurring_convolution )
+            return convolution_.Apply(in, out, workspace);
+        if( backend_ == blurring_separable )
+            return separable_.Apply(in, out, workspace);
+#ifdef DO_ARGCHECKS
+        if( in.Height() != out.Height() || in.Width() != out.Width() )
+            throw std::invalid_argument("Views of Apply must have the same size!");
+#endif // DO_ARGCHECKS
         size_t filter_offset = (filter_size_ - 1) / 2;
+        fourier_.RealConvolution2D(in, filter_freq_domain_->Data(), filter_offset, filter_offset, out, workspace);
+    }
 
-        #pragma omp parallel for simd collapse(2)
-        for(size_t row = 0; row < other.Height(); ++row)
-            for(size_t col = 0; col < other.Width(); ++col)
-                result[row*other.Width() + col] = full_result[(row+filter_offset)*full_result.Width() + (col+filter_offset)].real();
+    /** Access backend_
+     *  \return The backend applying the operator, never blurring_auto
+     */
+    BlurringBackend Backend() const noexcept
+    {
+        return backend_;
+    }
 
-        return result;
-#endif // BLURRING_CONVOLUTION
+    /** Access separable_
+     *  \return The separable approximation, with its rank and error, valid for blurring_separable only
+     */
+    const SeparableConvolution<T>& Separable() const noexcept
+    {
+        return separable_;
+    }
+
+    /** Backend selection
+     *  \brief Times the application of every backend on a picture of the given size and keeps the fastest one.
+     *  The choice is measured once per picture size, filter size and thread count and reused by the next operators.
+     *  The operation counts of the backends only order the measurements.
+     *  \param filter Blurring filter matrix
+     *  \param pic_size Size of the picture the operator is acting on
+     *  \return The fastest backend
+     */
+    static BlurringBackend Tune(const Matrix<T>& filter, size_t pic_size)
+    {
+        const std::tuple<size_t, size_t, size_t> key(pic_size, filter.Width(), (size_t) omp_get_max_threads());
+        std::lock_guard<std::mutex> lock(ChoicesMutex());
+        auto choice = Choices().find(key);
+        if( choice != Choices().end() )
+            return choice->second;
+
+        Matrix<T> picture((T)1, pic_size, pic_size);
+        Matrix<T> result(pic_size, pic_size);
+        BlurringBackend fastest = blurring_convolution;
+        double fastest_time = std::numeric_limits<double>::infinity();
+        // the backend expected to be the fastest runs first, so that a slow one is cut after a single run
+        const double length = std::pow(2,std::ceil(std::log2(pic_size + filter.Width() - 1)));
+        const bool direct_first = (double) pic_size*pic_size*filter.Length() < 6*length*length*std::log2(length);
+        const BlurringBackend candidates[2] = {direct_first ? blurring_convolution : blurring_fourier,
+                                               direct_first ? blurring_fourier : blurring_convolution};
+        for( BlurringBackend backend : candidates )
+        {
+            Blurring blurring(filter, pic_size, backend);
+            Workspace workspace;
+            double time = std::numeric_limits<double>::infinity();
+            for( size_t run = 0; run < 3; ++run )
+            {
+                std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+                blurring.Apply(picture, result, workspace);
+                std::chrono::duration<double> elapsed_time = std::chrono::high_resolution_clock::now() - start;
+                time = std::min(time, elapsed_time.count());
+
+                // the first run also sizes the workspace, a backend already far behind is not run again
+                if( time > 2*fastest_time )
+                    break;
+            }
+            if( time < fastest_time )
+            {
+                fastest = backend;
+                fastest_time = time;
+            }
+        }
+#ifdef DEBUG
+        std::cout << "Blurring : Tune chose backend=" << fastest << " for pic_size=" << pic_size << ", filter_size=" << filter.Width() << std::endl;
+#endif // DEBUG
 
+        Choices()[key] = fastest;
+        return fastest;
     }
 };
 
@@ -19,12 +19,23 @@ namespace alias
 template <class T = double>
 class Convolution : public Operator<T>
 {
+private:
+    bool mirrored_; //!< Member variable "mirrored_" filter equal to its left-right mirror, its symmetric columns share their products
+
+    /** Rows of a tile of the interior, each loaded picture row feeds all of them
+     */
+    static constexpr size_t tile_rows = 4;
+    /** Columns of a tile of the interior, two vector registers of the widest instruction set
+     */
+    static constexpr size_t tile_cols = 2 * 64 / sizeof(T);
+
 public:
 
     /** Default constructor
      */
     Convolution()
         : Operator<T>()
+        , mirrored_(false)
     {
 #ifdef DEBUG
         std::cout << "Convolution : Default constructor called" << std::endl;
@@ -36,6 +47,7 @@ public:
      */
     Convolution(const Convolution& other)
         : Operator<T>(other)
+        , mirrored_(other.mirrored_)
     {
 #ifdef DEBUG
         std::cout << "Convolution : Copy constructor called" << std::endl;
@@ -59,6 +71,7 @@ public:
      */
     explicit Convolution(Matrix<T> data)
         : Operator<T>(data, data.Height(), data.Width(), false)
+        , mirrored_(true)
     {
 #ifdef DO_ARGCHECKS
         if( this->height_ % 2 != 1 || this->width_ % 2 != 1 )
@@ -67,6 +80,11 @@ public:
 #ifdef DEBUG
         std::cout << "Convolution : Full member constructor called" << std::endl;
 #endif // DEBUG
+
+        for( size_t row = 0; row < data.Height(); ++row )
+            for( size_t col = 0; col < data.Width()/2; ++col )
+                if( data[row*data.Width() + col] != data[row*data.Width() + data.Width() - col - 1] )
+                    mirrored_ = false;
     }
 
     /** Clone function
@@ -91,7 +109,7 @@ public:
      */
     bool IsValid() const override final
     {
-        if( this->height_ != 0 && this->width_ != 0 && !this->data_.IsEmpty() && this->height_ % 2 == 1 && this->width_ % 2 == 1 )
+        if( this->height_ != 0 && this->width_ != 0 && !this->data_->IsEmpty() && this->height_ % 2 == 1 && this->width_ % 2 == 1 )
             return true;
         else
             throw std::invalid_argument("Convolution dimensions must be non-zero and odd, and data shall not be empty!");
@@ -106,6 +124,7 @@ public:
         using std::swap;
 
         swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
+        swap(first.mirrored_, second.mirrored_);
     }
 
     /** Copy assignment operator
@@ -129,37 +148,177 @@ public:
             throw std::invalid_argument("Can not perform a convolution with these Matrices.");
 #endif // DO_ARGCHECKS
 
-        Matrix<T> result((T) 0, other.Height(), other.Width());
+        Matrix<T> result(other.Height(), other.Width());
+        Apply(other, result, Workspace::Local());
+
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \brief The interior, where the filter lies inside the picture, is computed by tiles of tile_rows by tile_cols
+     *  pixels held in registers. The border goes through the clipped sums of Border.
+     *  \param in Picture to convolve
+     *  \param out Result of the same size as in, not overlapping in
+     *  \param workspace Scratch memory, unused
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        (void) workspace;
+#ifdef DO_ARGCHECKS
+        if( in.Height() != out.Height() || in.Width() != out.Width() )
+            throw std::invalid_argument("Views of Apply must have the same size!");
+#endif // DO_ARGCHECKS
+
+        const size_t height_dist_from_center = (this->height_ - 1) / 2;
+        const size_t width_dist_from_center = (this->width_ - 1) / 2;
 
-        size_t height_dist_from_center = (this->height_ - 1) / 2;
-        size_t width_dist_from_center = (this->width_ - 1) / 2;
+        // interior rows [row_begin, row_end) and columns [col_begin, col_end)
+        const size_t row_begin = std::min(height_dist_from_center, in.Height());
+        const size_t row_end = std::max(row_begin, in.Height() > height_dist_from_center ? in.Height() - height_dist_from_center : 0);
+        const size_t col_begin = std::min(width_dist_from_center, in.Width());
+        const size_t col_end = std::max(col_begin, in.Width() > width_dist_from_center ? in.Width() - width_dist_from_center : 0);
+        const size_t row_blocks = (row_end - row_begin) / tile_rows;
+        const size_t col_blocks = col_end - col_begin < tile_cols ? 0 : (col_end - col_begin + tile_cols - 1) / tile_cols;
 
-        #pragma omp parallel for
-        for( size_t row = 0; row < other.Height(); ++row )
+        #pragma omp parallel
         {
-            int relative_dist_row = row - height_dist_from_center;
-            int filter_start_row = relative_dist_row < 0 ? -relative_dist_row : 0;
-            int matrix_start_row = relative_dist_row < 0 ? 0 : relative_dist_row;
-            for( size_t col = 0; col < other.Width(); ++col )
+            // tiles of full height, the last tile of each row is moved back to end on the interior and only writes its new columns
+            #pragma omp for schedule(static) nowait
+            for( size_t block = 0; block < row_blocks*col_blocks; ++block )
+            {
+                const size_t row = row_begin + (block / col_blocks) * tile_rows;
+                const size_t col = col_begin + (block % col_blocks) * tile_cols;
+                Tile<tile_rows>(in, out, row, std::min(col, col_end - tile_cols), col);
+            }
+
+            // remaining interior rows, one by one
+            #pragma omp for schedule(static) nowait
+            for( size_t block = 0; block < (row_end - row_begin - row_blocks*tile_rows)*col_blocks; ++block )
+            {
+                const size_t row = row_begin + row_blocks*tile_rows + block / col_blocks;
+                const size_t col = col_begin + (block % col_blocks) * tile_cols;
+                Tile<1>(in, out, row, std::min(col, col_end - tile_cols), col);
+            }
+
+            // border, and the interior itself when it is narrower than a tile
+            #pragma omp for schedule(dynamic, 16)
+            for( size_t row = 0; row < in.Height(); ++row )
             {
-                int relative_dist_col = col - width_dist_from_center;
-                int filter_start_col = relative_dist_col < 0 ? - relative_dist_col : 0;
-                int matrix_start_col = relative_dist_col < 0 ? 0 : relative_dist_col;
-                for(size_t filter_row = filter_start_row, matrix_row = matrix_start_row;
-                    filter_row < this->Height() && matrix_row < other.Height();
-                    ++filter_row, ++matrix_row)
+                if( row < row_begin || row >= row_end || col_blocks == 0 )
+                {
+                    for( size_t col = 0; col < in.Width(); ++col )
+                        out(row, col) = Border(in, row, col);
+                }
+                else
                 {
-                    for(size_t filter_col = filter_start_col, matrix_col = matrix_start_col;
-                        filter_col < this->Width() && matrix_col < other.Width();
-                        ++filter_col, ++matrix_col)
+                    for( size_t col = 0; col < col_begin; ++col )
+                        out(row, col) = Border(in, row, col);
+                    for( size_t col = col_end; col < in.Width(); ++col )
+                        out(row, col) = Border(in, row, col);
+                }
+            }
+        }
+    }
+
+private:
+    /** Clipped sum
+     *  \param in Picture to convolve
+     *  \param row Row of the result
+     *  \param col Column of the result
+     *  \return The sum of the products of the filter with the part of the picture it covers
+     */
+    T Border(const MatrixView<T>& in, size_t row, size_t col) const
+    {
+        const size_t height_dist_from_center = (this->height_ - 1) / 2;
+        const size_t width_dist_from_center = (this->width_ - 1) / 2;
+        const T* filter = this->data_->Data();
+
+        int relative_dist_row = row - height_dist_from_center;
+        int filter_start_row = relative_dist_row < 0 ? -relative_dist_row : 0;
+        int matrix_start_row = relative_dist_row < 0 ? 0 : relative_dist_row;
+        int relative_dist_col = col - width_dist_from_center;
+        int filter_start_col = relative_dist_col < 0 ? - relative_dist_col : 0;
+        int matrix_start_col = relative_dist_col < 0 ? 0 : relative_dist_col;
+        T sum = 0;
+        for(size_t filter_row = filter_start_row, matrix_row = matrix_start_row;
+            filter_row < this->height_ && matrix_row < in.Height();
+            ++filter_row, ++matrix_row)
+        {
+            for(size_t filter_col = filter_start_col, matrix_col = matrix_start_col;
+                filter_col < this->width_ && matrix_col < in.Width();
+                ++filter_col, ++matrix_col)
+            {
+                sum += in(matrix_row, matrix_col) * filter[filter_row * this->width_ + filter_col];
+            }
+        }
+        return sum;
+    }
+
+    /** Interior tile
+     *  \brief Every picture row under the tile feeds all the rows of the tile it contributes to, the sums stay in
+     *  registers. A mirrored filter adds the symmetric columns before multiplying, halving the multiplications.
+     *  \param in Picture to convolve
+     *  \param out Result
+     *  \param row First row of the tile, the filter lies inside the picture for all its rows
+     *  \param col First column of the tile, the filter lies inside the picture for all its columns
+     *  \param write_col First column written to out, the previous ones belong to another tile
+     */
+    template <size_t rows>
+    void Tile(const MatrixView<T>& in, const MatrixView<T>& out, size_t row, size_t col, size_t write_col) const
+    {
+        const size_t filter_height = this->height_;
+        const size_t filter_width = this->width_;
+        const size_t width_dist_from_center = (filter_width - 1) / 2;
+        const T* filter = this->data_->Data();
+
+        T sum[rows][tile_cols] = {};
+        for( size_t offset = 0; offset < filter_height + rows - 1; ++offset )
+        {
+            const T* picture = &in(row + offset - (filter_height - 1) / 2, col - width_dist_from_center);
+            if( mirrored_ )
+            {
+                for( size_t filter_col = 0; filter_col <= width_dist_from_center; ++filter_col )
+                {
+                    const size_t mirror_col = filter_width - filter_col - 1;
+                    for( size_t tile_row = 0; tile_row < rows; ++tile_row )
                     {
-                        result[row * other.Width() + col] += other[matrix_row * other.Width() + matrix_col] * this->data_[filter_row * this->width_ + filter_col];
+                        const size_t filter_row = offset - tile_row;
+                        if( offset < tile_row || filter_row >= filter_height )
+                            continue;
+                        const T factor = filter[filter_row*filter_width + filter_col];
+                        if( filter_col == mirror_col )
+                        {
+                            #pragma omp simd
+                            for( size_t i = 0; i < tile_cols; ++i )
+                                sum[tile_row][i] += factor * picture[i + filter_col];
+                        }
+                        else
+                        {
+                            #pragma omp simd
+                            for( size_t i = 0; i < tile_cols; ++i )
+                                sum[tile_row][i] += factor * (picture[i + filter_col] + picture[i + mirror_col]);
+                        }
                     }
                 }
             }
+            else
+            {
+                for( size_t filter_col = 0; filter_col < filter_width; ++filter_col )
+                    for( size_t tile_row = 0; tile_row < rows; ++tile_row )
+                    {
+                        const size_t filter_row = offset - tile_row;
+                        if( offset < tile_row || filter_row >= filter_height )
+                            continue;
+                        const T factor = filter[filter_row*filter_width + filter_col];
+                        #pragma omp simd
+                        for( size_t i = 0; i < tile_cols; ++i )
+                            sum[tile_row][i] += factor * picture[i + filter_col];
+                    }
+            }
         }
 
-        return result;
+        for( size_t tile_row = 0; tile_row < rows; ++tile_row )
+            std::copy(sum[tile_row] + write_col - col, sum[tile_row] + tile_cols, &out(row + tile_row, write_col));
     }
 };
 
@@ -11,9 +11,13 @@
 #ifndef ASTROQUT_UTILS_OPERATOR_FOURIER_HPP
 #define ASTROQUT_UTILS_OPERATOR_FOURIER_HPP
 
+#include "utils/linearop/matrix/view.hpp"
 #include "utils/linearop/operator.hpp"
 
 #include <complex>
+#include <map>
+#include <mutex>
+#include <omp.h>
 
 namespace alias
 {
@@ -43,9 +47,85 @@ template <class T = double>
 class Fourier : public Operator<T>
 {
 private:
+    /** Transform plan
+     *  \brief Everything a transform of a given length needs, built once and shared by all the operators of that length
+     */
+    struct Plan
+    {
+        Matrix<size_t> bit_reverse; //!< Member variable "bit_reverse" bit reversed index of every sample
+        Matrix<T> twiddles; //!< Member variable "twiddles" for every radix-4 stage of quarter length h, the real then imaginary parts of the h twiddles of the samples 1, 2 and 3 of the butterflies
+    };
+
     size_t depth_max_;
-    Matrix<size_t> bit_reverse_table_;
-    Matrix<std::complex<T>> roots_of_unity_;
+    Shared<Plan> plan_;
+
+    /** Plans built so far, indexed by length
+     */
+    static std::map<size_t, Shared<Plan>>& Plans()
+    {
+        static std::map<size_t, Shared<Plan>> plans;
+        return plans;
+    }
+    static std::mutex& PlansMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    /** Plan of a given length
+     *  \brief Builds the plan the first time a length is asked, then hands out the same one
+     *  \param length Length of the transform, a power of 2
+     *  \return The shared plan
+     */
+    static Shared<Plan> MakePlan(size_t length)
+    {
+        std::lock_guard<std::mutex> lock(PlansMutex());
+        auto plan = Plans().find(length);
+        if( plan != Plans().end() )
+            return plan->second;
+
+        const size_t depth_max = std::log2(length);
+        Plan result;
+
+        // build bit reverse lookup table
+        result.bit_reverse = Matrix<size_t>(length, 1);
+        for( size_t i = 0; i < length; ++i )
+        {
+            size_t num = i;
+            size_t reverse_num = 0;
+            for( size_t bit = 0; bit < depth_max; ++bit )
+            {
+                reverse_num = (reverse_num << 1) | (num & 1);
+                num >>= 1;
+            }
+            result.bit_reverse[i] = reverse_num;
+        }
+
+        // build the twiddles of every radix-4 stage, an odd depth starts with a radix-2 stage without twiddles
+        size_t twiddle_count = 0;
+        for( size_t h = (depth_max % 2 == 1) ? 2 : 1; h < length; h *= 4 )
+            twiddle_count += 6*h;
+        result.twiddles = Matrix<T>((T)0, std::max(twiddle_count, (size_t) 1), 1);
+        T* twiddles = result.twiddles.Data();
+        for( size_t h = (depth_max % 2 == 1) ? 2 : 1; h < length; h *= 4 )
+        {
+            for( size_t col = 0; col < h; ++col )
+            {
+                const double angle = - 2.0 * PI * col / (4*h);
+                twiddles[col] = std::cos(2*angle);
+                twiddles[h + col] = std::sin(2*angle);
+                twiddles[2*h + col] = std::cos(angle);
+                twiddles[3*h + col] = std::sin(angle);
+                twiddles[4*h + col] = std::cos(3*angle);
+                twiddles[5*h + col] = std::sin(3*angle);
+            }
+            twiddles += 6*h;
+        }
+
+        Plans()[length] = std::move(result);
+        return Plans()[length];
+    }
+
 public:
 
     /** Default constructor
@@ -53,8 +133,7 @@ public:
     Fourier()
         : Operator<T>()
         , depth_max_(0)
-        , bit_reverse_table_()
-        , roots_of_unity_()
+        , plan_()
     {
 #ifdef DEBUG
         std::cout << "Fourier : Default constructor called" << std::endl;
@@ -67,8 +146,7 @@ public:
     Fourier(const Fourier& other)
         : Operator<T>(other)
         , depth_max_(other.depth_max_)
-        , bit_reverse_table_(other.bit_reverse_table_)
-        , roots_of_unity_(other.roots_of_unity_)
+        , plan_(other.plan_)
     {
 #ifdef DEBUG
         std::cout << "Fourier : Copy constructor called" << std::endl;
@@ -93,37 +171,15 @@ public:
     explicit Fourier(size_t length)
         : Operator<T>(length, length)
         , depth_max_(std::log2(length))
-        , bit_reverse_table_(Matrix<size_t>(length, 1))
-        , roots_of_unity_(Matrix<std::complex<T>>(length - 1, 1))
+        , plan_(MakePlan(length))
     {
 #ifdef DEBUG
         std::cout << "Fourier : Build constructor called with length=" << length << std::endl;
 #endif // DEBUG
-
-        // build bit reverse lookup table
-        for( size_t i = 0; i < length; ++i )
-        {
-            int num = i;
-            int reverse_num = 0;
-            int bit_count = depth_max_;
-
-            while(bit_count-- > 0)
-            {
-                reverse_num <<= 1;
-                reverse_num |= num & 1;
-                num >>= 1;
-            }
-
-            bit_reverse_table_[i] = reverse_num;
-        }
-
-        // build roots of unity
-        for( size_t depth = 1; depth <= depth_max_; ++depth )
-        {
-            double depth_length = std::pow(2, depth);
-            for(size_t col = 0; col < depth_length/2; ++col)
-                roots_of_unity_[std::pow(2,depth-1) - 1 + col] = std::exp( std::complex(0.0, - 2.0 * PI * col / depth_length ) );
-        }
+#ifdef DO_ARGCHECKS
+        if( length == 0 || (length & (length - 1)) != 0 )
+            throw std::invalid_argument("The length of the Fourier transform must be a power of 2!");
+#endif // DO_ARGCHECKS
     }
 
     /** Clone function
@@ -148,7 +204,7 @@ public:
      */
     bool IsValid() const override final
     {
-        if( this->height_ != 0 && this->width_ != 0 && depth_max_ != 0 && !bit_reverse_table_.IsEmpty() && !roots_of_unity_.IsEmpty() )
+        if( this->height_ != 0 && this->width_ != 0 && depth_max_ != 0 && !plan_->bit_reverse.IsEmpty() && !plan_->twiddles.IsEmpty() )
             return true;
 
         throw std::invalid_argument("Operator dimensions must be non-zero and function shall not be nullptr!");
@@ -164,8 +220,7 @@ public:
 
         swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
         swap(first.depth_max_, second.depth_max_);
-        swap(first.bit_reverse_table_, second.bit_reverse_table_);
-        swap(first.roots_of_unity_, second.roots_of_unity_);
+        swap(first.plan_, second.plan_);
     }
 
     /** Copy assignment operator
@@ -185,46 +240,86 @@ public:
         return Matrix<T>(other);
     }
 
-    /** Fast Fourier Transform for temporary instances
-     *  \brief Iterative FFT
-     *  \param signal Input signal to transform with the FFT
-     *  \param result Resulting matrix
+    /** Fast Fourier Transform
+     *  \brief Iterative decimation in time FFT, the samples are put in bit reversed order then combined by radix-4
+     *  butterflies, each one doing the work of two radix-2 stages. An odd depth starts with a radix-2 stage.
+     *  \param signal Input signal to transform with the FFT, samples past its length are considered zero
+     *  \param signal_length Amount of samples in signal
+     *  \param result Resulting signal of the length of the operator, not overlapping signal
      *  \author Community from https://en.wikipedia.org/wiki/Cooley%E2%80%93Tukey_FFT_algorithm
      *  \author Philippe Ganz <philippe.ganz@gmail.com> 2018-2019
      */
-    void FFT( const Matrix<std::complex<T>>& signal, Matrix<std::complex<T>>& result ) const
+    template <bool inverse = false>
+    void Transform( const std::complex<T>* signal, size_t signal_length, std::complex<T>* result ) const
     {
+        const size_t length = this->Width();
+        const size_t* bit_reverse = plan_->bit_reverse.Data();
+
         // bit reversal step
-        #pragma omp parallel for simd
-        for( size_t i = 0; i < this->Width(); ++i )
-            if( bit_reverse_table_[i] < signal.Length() )
-                result[i] = signal[bit_reverse_table_[i]];
+        for( size_t i = 0; i < length; ++i )
+            result[i] = bit_reverse[i] < signal_length ? signal[bit_reverse[i]] : std::complex<T>(0);
 
-        // iterative radix-2 FFT
-        for( size_t depth = 1; depth <= depth_max_; ++depth )
+        // complex arrays are arrays of real and imaginary parts
+        T* data = reinterpret_cast<T*>(result);
+        size_t h = 1;
+        if( depth_max_ % 2 == 1 )
         {
-            size_t depth_length = std::pow(2,depth);
-            #pragma omp parallel for simd
-            for( size_t row = 0; row < this->Width(); row += depth_length )
-                for( size_t col = 0; col < depth_length/2; ++col )
-                {
-                    std::complex<T> e_k = result[ row + col ];
-                    std::complex<T> o_k = roots_of_unity_[std::pow(2,depth-1) - 1 + col] * result[ row + col + depth_length/2 ];
-                    result[ row + col ] = e_k + o_k;
-                    result[ row + col + depth_length/2 ] = e_k - o_k;
-                }
+            #pragma omp simd
+            for( size_t row = 0; row < 2*length; row += 4 )
+            {
+                const T a_re = data[row], a_im = data[row+1];
+                const T b_re = data[row+2], b_im = data[row+3];
+                data[row] = a_re + b_re;
+                data[row+1] = a_im + b_im;
+                data[row+2] = a_re - b_re;
+                data[row+3] = a_im - b_im;
+            }
+            h = 2;
+        }
+        else if( length >= 4 )
+        {
+            // the first radix-4 stage has no twiddle
+            #pragma omp simd
+            for( size_t row = 0; row < 2*length; row += 8 )
+                Butterfly<inverse>(data + row, 1, 0, (T)1, (T)0, (T)1, (T)0, (T)1, (T)0);
+            h = 4;
+        }
+
+        const T* twiddles = plan_->twiddles.Data() + (depth_max_ % 2 == 1 ? 0 : 6);
+        for( ; h < length; h *= 4 )
+        {
+            for( size_t row = 0; row < 2*length; row += 8*h )
+            {
+                T* group = data + row;
+                #pragma omp simd
+                for( size_t col = 0; col < h; ++col )
+                    Butterfly<inverse>(group, h, col,
+                                       twiddles[col], twiddles[h + col],
+                                       twiddles[2*h + col], twiddles[3*h + col],
+                                       twiddles[4*h + col], twiddles[5*h + col]);
+            }
+            twiddles += 6*h;
         }
     }
 
-    void IFFT( const Matrix<std::complex<T>>& signal, Matrix<std::complex<T>>& result ) const
+    /** Fast Fourier Transform for temporary instances
+     *  \param signal Input signal to transform with the FFT, samples past its length are considered zero
+     *  \param result Resulting matrix
+     */
+    void FFT( const Matrix<std::complex<T>>& signal, Matrix<std::complex<T>>& result ) const
     {
-        // compute a forward FFT of the signal and divide by signal length
-        FFT(signal, result);
-        result /= signal.Length();
+        Transform(signal.Data(), signal.Length(), result.Data());
+    }
 
-        // mirror all the values except the first one
-        for( size_t i = 1; i < signal.Length()/2; ++i )
-            std::swap(result[i], result[signal.Length() - i]);
+    void IFFT( const Matrix<std::complex<T>>& signal, Matrix<std::complex<T>>& result ) const
+    {
+        // transform with the conjugated twiddles and divide by the length
+        Transform<true>(signal.Data(), signal.Length(), result.Data());
+        const T scale = (T)1 / this->Width();
+        T* data = reinterpret_cast<T*>(result.Data());
+        #pragma omp simd
+        for( size_t i = 0; i < 2*this->Width(); ++i )
+            data[i] *= scale;
     }
 
     /** 2D Fast Fourier Transform
@@ -237,29 +332,25 @@ public:
         Matrix<std::complex<T>> result(0, this->Height(), this->Width());
 
         // compute a 1D FFT for every row of the signal
-        #pragma omp parallel for simd
+        #pragma omp parallel for
         for( size_t row = 0; row < signal.Height(); ++row )
         {
-            Matrix<std::complex<T>> input_row(signal.Data() + row*signal.Width(), signal.Width(), 1);
-            Matrix<std::complex<T>> result_row(result.Data() + row*result.Width(), result.Width(), 1);
+            const Matrix<std::complex<T>> input_row = MatrixView<std::complex<T>>(signal).Row(row).Borrow();
+            Matrix<std::complex<T>> result_row = MatrixView<std::complex<T>>(result).Row(row).Borrow();
             FFT(input_row, result_row);
-            input_row.Data(nullptr);
-            result_row.Data(nullptr);
         }
 
-        // transpose the result
-        Matrix<std::complex<T>> result_transposed = result.Transpose();
+        // transpose the result in-place
+        Matrix<std::complex<T>> result_transposed = std::move(result).Transpose();
         Matrix<std::complex<T>> result_final(0, this->Height(), this->Width());
 
         // compute a 1D FFT for every row of the transposed intermediate result, i.e. the columns of the previous FFT
-        #pragma omp parallel for simd
+        #pragma omp parallel for
         for( size_t row = 0; row < result_transposed.Height(); ++row )
         {
-            Matrix<std::complex<T>> input_row(result_transposed.Data() + row*result_transposed.Width(), signal.Width(), 1);
-            Matrix<std::complex<T>> result_row(result_final.Data() + row*result_final.Width(), result.Width(), 1);
+            const Matrix<std::complex<T>> input_row = MatrixView<std::complex<T>>(result_transposed).Row(row).Borrow();
+            Matrix<std::complex<T>> result_row = MatrixView<std::complex<T>>(result_final).Row(row).Borrow();
             FFT(input_row, result_row);
-            input_row.Data(nullptr);
-            result_row.Data(nullptr);
         }
 
         // transpose back to have the original orientation
@@ -272,35 +363,288 @@ public:
         Matrix<std::complex<T>> result(this->Height(), this->Width());
 
         // compute a 1D IFFT for every row of the signal
-        #pragma omp parallel for simd
+        #pragma omp parallel for
         for( size_t row = 0; row < signal.Height(); ++row )
         {
-            Matrix<std::complex<T>> input_row(signal.Data() + row*signal.Width(), signal.Width(), 1);
-            Matrix<std::complex<T>> result_row(result.Data() + row*result.Width(), result.Width(), 1);
+            const Matrix<std::complex<T>> input_row = MatrixView<std::complex<T>>(signal).Row(row).Borrow();
+            Matrix<std::complex<T>> result_row = MatrixView<std::complex<T>>(result).Row(row).Borrow();
             IFFT(input_row, result_row);
-            input_row.Data(nullptr);
-            result_row.Data(nullptr);
         }
 
         // transpose the result in-place
-        Matrix<std::complex<T>> result_transposed = result.Transpose();
+        Matrix<std::complex<T>> result_transposed = std::move(result).Transpose();
         Matrix<std::complex<T>> result_final(0, this->Height(), this->Width());
 
         // compute a 1D IFFT for every row of the transposed intermediate result, i.e. the columns of the previous IFFT
-        #pragma omp parallel for simd
-        for( size_t row = 0; row < result.Height(); ++row )
+        #pragma omp parallel for
+        for( size_t row = 0; row < result_transposed.Height(); ++row )
         {
-            Matrix<std::complex<T>> input_row(result_transposed.Data() + row*result_transposed.Width(), signal.Width(), 1);
-            Matrix<std::complex<T>> result_row(result_final.Data() + row*result_final.Width(), result.Width(), 1);
+            const Matrix<std::complex<T>> input_row = MatrixView<std::complex<T>>(result_transposed).Row(row).Borrow();
+            Matrix<std::complex<T>> result_row = MatrixView<std::complex<T>>(result_final).Row(row).Borrow();
             IFFT(input_row, result_row);
-            input_row.Data(nullptr);
-            result_row.Data(nullptr);
         }
 
         // transpose back to have the original orientation
         std::move(result_final).Transpose();
         return result_final;
     }
+
+    /** Length of the stored columns of a real spectrum
+     *  \return The amount of columns of the spectrum of a real signal that are stored, the others are the conjugates of the mirrored ones
+     */
+    size_t HalfWidth() const noexcept
+    {
+        return this->Width()/2 + 1;
+    }
+
+    /** 2D Fast Fourier Transform of a real signal
+     *  \brief Only the first HalfWidth columns of the spectrum are computed. They are stored one after the other, so
+     *  that the column pass runs on contiguous data.
+     *  \param signal Real signal, zero-padded to the size of the operator
+     *  \param spectrum Columns of the spectrum, HalfWidth times the length of the operator, overwritten
+     *  \param workspace Scratch memory, left as it was found
+     */
+    void RealFFT2D( const MatrixView<T>& signal, std::complex<T>* spectrum, Workspace& workspace ) const
+    {
+        Workspace::Frame frame(workspace);
+        const size_t length = this->Width();
+        std::complex<T>* scratch = workspace.Allocate<std::complex<T>>(omp_get_max_threads()*ScratchLength());
+
+        RealRowsFFT(signal, spectrum, scratch);
+
+        #pragma omp parallel for schedule(static)
+        for( size_t col = 0; col < HalfWidth(); ++col )
+        {
+            std::complex<T>* column = spectrum + col*length;
+            std::complex<T>* temp = scratch + omp_get_thread_num()*ScratchLength();
+            Transform(column, signal.Height(), temp);
+            std::copy(temp, temp + length, column);
+        }
+    }
+
+    /** 2D cyclic convolution of a real signal
+     *  \brief The spectrum of the signal is computed as in RealFFT2D. Every column of it is multiplied by the same
+     *  column of the filter spectrum as soon as it is transformed, then transformed back. The inverse row pass only
+     *  runs on the rows of the result.
+     *  \param signal Real signal, zero-padded to the size of the operator
+     *  \param filter Columns of the spectrum of the filter as given by RealFFT2D, divided by the square of the length of
+     *  the operator
+     *  \param row_offset First row of the convolution written to result
+     *  \param col_offset First column of the convolution written to result
+     *  \param result Part of the convolution, overwritten
+     *  \param workspace Scratch memory, left as it was found
+     */
+    void RealConvolution2D( const MatrixView<T>& signal, const std::complex<T>* filter, size_t row_offset, size_t col_offset, MatrixView<T> result, Workspace& workspace ) const
+    {
+#ifdef DO_ARGCHECKS
+        if( row_offset + result.Height() > this->Height() || col_offset + result.Width() > this->Width() )
+            throw std::invalid_argument("The result must lie inside the convolution!");
+#endif // DO_ARGCHECKS
+        Workspace::Frame frame(workspace);
+        const size_t length = this->Width();
+        std::complex<T>* spectrum = workspace.Allocate<std::complex<T>>(HalfWidth()*length);
+        std::complex<T>* scratch = workspace.Allocate<std::complex<T>>(omp_get_max_threads()*ScratchLength());
+
+        RealRowsFFT(signal, spectrum, scratch);
+
+        #pragma omp parallel for schedule(static)
+        for( size_t col = 0; col < HalfWidth(); ++col )
+        {
+            std::complex<T>* column = spectrum + col*length;
+            std::complex<T>* temp = scratch + omp_get_thread_num()*ScratchLength();
+            Transform(column, signal.Height(), temp);
+
+            T* data = reinterpret_cast<T*>(temp);
+            const T* filter_column = reinterpret_cast<const T*>(filter + col*length);
+            #pragma omp simd
+            for( size_t i = 0; i < 2*length; i += 2 )
+            {
+                const T re = data[i]*filter_column[i] - data[i+1]*filter_column[i+1];
+                const T im = data[i]*filter_column[i+1] + data[i+1]*filter_column[i];
+                data[i] = re;
+                data[i+1] = im;
+            }
+
+            Transform<true>(temp, length, column);
+        }
+
+        RealRowsIFFT(spectrum, row_offset, col_offset, result, scratch);
+    }
+
+private:
+    /** Rows of a batch of the row passes, their values in every column of the spectrum fill two cache lines
+     */
+    static constexpr size_t batch_rows = 2 * 64 / sizeof(std::complex<T>);
+
+    /** Scratch memory of one thread
+     *  \return The amount of complex values a thread uses in the real transforms
+     */
+    size_t ScratchLength() const noexcept
+    {
+        return 2*this->Width() + batch_rows*HalfWidth();
+    }
+
+    /** Row pass of RealFFT2D
+     *  \brief Two real rows are transformed at once as the real and imaginary parts of a complex row. Their spectra
+     *  are untangled with the Hermitian symmetry, X[k] = (Z[k] + conj(Z[-k]))/2 and Y[k] = (Z[k] - conj(Z[-k]))/(2i).
+     *  The rows are transformed by batches, and a batch is written to the columns of the spectrum at once.
+     *  \param signal Real signal
+     *  \param spectrum Columns of the spectrum, only their first signal.Height() rows are written
+     *  \param scratch ScratchLength complex values per thread
+     */
+    void RealRowsFFT( const MatrixView<T>& signal, std::complex<T>* spectrum, std::complex<T>* scratch ) const
+    {
+        const size_t length = this->Width();
+        const size_t half_width = HalfWidth();
+
+        #pragma omp parallel for schedule(static)
+        for( size_t row_begin = 0; row_begin < signal.Height(); row_begin += batch_rows )
+        {
+            std::complex<T>* pair = scratch + omp_get_thread_num()*ScratchLength();
+            std::complex<T>* pair_spectrum = pair + length;
+            std::complex<T>* batch = pair_spectrum + length;
+            const size_t rows = std::min(batch_rows, signal.Height() - row_begin);
+
+            for( size_t row = 0; row < rows; row += 2 )
+            {
+                const bool second = row + 1 < rows;
+                for( size_t col = 0; col < signal.Width(); ++col )
+                    pair[col] = std::complex<T>(signal(row_begin + row, col), second ? signal(row_begin + row + 1, col) : (T)0);
+                Transform(pair, signal.Width(), pair_spectrum);
+
+                std::complex<T>* first_spectrum = batch + row*half_width;
+                std::complex<T>* second_spectrum = first_spectrum + half_width;
+                for( size_t k = 0; k < half_width; ++k )
+                {
+                    const std::complex<T> z = pair_spectrum[k];
+                    const std::complex<T> z_mirror = std::conj(pair_spectrum[(length - k) & (length - 1)]);
+                    const std::complex<T> difference = z - z_mirror;
+                    first_spectrum[k] = (T)0.5 * (z + z_mirror);
+                    second_spectrum[k] = std::complex<T>((T)0.5 * difference.imag(), (T)-0.5 * difference.real());
+                }
+            }
+
+            // transposed write, every column receives the rows of the batch side by side
+            for( size_t k = 0; k < half_width; ++k )
+                for( size_t row = 0; row < rows; ++row )
+                    spectrum[k*length + row_begin + row] = batch[row*half_width + k];
+        }
+    }
+
+    /** Row pass of the inverse transform of RealConvolution2D
+     *  \brief The rows are gathered from the columns of the spectrum by batches. Two rows of real signals go through
+     *  one complex transform, the half spectra being completed by their conjugates, and come out as its real and
+     *  imaginary parts.
+     *  \param spectrum Columns of the spectrum, transformed back
+     *  \param row_offset First row written to result
+     *  \param col_offset First column written to result
+     *  \param result Rows and columns of the signal, overwritten
+     *  \param scratch ScratchLength complex values per thread
+     */
+    void RealRowsIFFT( const std::complex<T>* spectrum, size_t row_offset, size_t col_offset, MatrixView<T>& result, std::complex<T>* scratch ) const
+    {
+        const size_t length = this->Width();
+        const size_t half_width = HalfWidth();
+
+        #pragma omp parallel for schedule(static)
+        for( size_t row_begin = 0; row_begin < result.Height(); row_begin += batch_rows )
+        {
+            std::complex<T>* pair_spectrum = scratch + omp_get_thread_num()*ScratchLength();
+            std::complex<T>* pair = pair_spectrum + length;
+            std::complex<T>* batch = pair + length;
+            const size_t rows = std::min(batch_rows, result.Height() - row_begin);
+
+            // transposed read, every column gives the rows of the batch side by side, a missing last row is zero
+            for( size_t k = 0; k < half_width; ++k )
+                for( size_t row = 0; row < rows; ++row )
+                    batch[row*half_width + k] = spectrum[k*length + row_offset + row_begin + row];
+            if( rows % 2 == 1 )
+                std::fill(batch + rows*half_width, batch + (rows + 1)*half_width, std::complex<T>(0));
+
+            for( size_t row = 0; row < rows; row += 2 )
+            {
+                const std::complex<T>* first_spectrum = batch + row*half_width;
+                const std::complex<T>* second_spectrum = first_spectrum + half_width;
+
+                // the first and middle coefficients of a real signal are real
+                pair_spectrum[0] = std::complex<T>(first_spectrum[0].real(), second_spectrum[0].real());
+                pair_spectrum[length/2] = std::complex<T>(first_spectrum[length/2].real(), second_spectrum[length/2].real());
+                for( size_t k = 1; k < length/2; ++k )
+                {
+                    const std::complex<T> a = first_spectrum[k];
+                    const std::complex<T> b = second_spectrum[k];
+                    pair_spectrum[k] = std::complex<T>(a.real() - b.imag(), a.imag() + b.real());
+                    pair_spectrum[length - k] = std::complex<T>(a.real() + b.imag(), b.real() - a.imag());
+                }
+                Transform<true>(pair_spectrum, length, pair);
+
+                for( size_t col = 0; col < result.Width(); ++col )
+                    result(row_begin + row, col) = pair[col_offset + col].real();
+                if( row + 1 < rows )
+                    for( size_t col = 0; col < result.Width(); ++col )
+                        result(row_begin + row + 1, col) = pair[col_offset + col].imag();
+            }
+        }
+    }
+
+    /** Radix-4 butterfly
+     *  \brief Combines four transforms of length h into one of length 4h, doing the two radix-2 stages at once.
+     *  The products are written out by real and imaginary parts, the complex product checking for infinities does not vectorize.
+     *  \param data Group of 4h complex samples, as real and imaginary parts
+     *  \param h Length of the combined transforms
+     *  \param col Index of the butterfly in the group
+     *  \param w1_re, w1_im Twiddle of sample 1, w^(2 col) with w the 4h-th root of unity
+     *  \param w2_re, w2_im Twiddle of sample 2, w^col
+     *  \param w3_re, w3_im Twiddle of sample 3, w^(3 col)
+     */
+    template <bool inverse>
+    static inline void Butterfly( T* data, size_t h, size_t col, T w1_re, T w1_im, T w2_re, T w2_im, T w3_re, T w3_im )
+    {
+        // the inverse transform uses the conjugated roots of unity
+        if( inverse )
+        {
+            w1_im = -w1_im;
+            w2_im = -w2_im;
+            w3_im = -w3_im;
+        }
+        T* a0 = data + 2*col;
+        T* a1 = data + 2*(col + h);
+        T* a2 = data + 2*(col + 2*h);
+        T* a3 = data + 2*(col + 3*h);
+
+        const T p1_re = w1_re*a1[0] - w1_im*a1[1];
+        const T p1_im = w1_re*a1[1] + w1_im*a1[0];
+        const T p2_re = w2_re*a2[0] - w2_im*a2[1];
+        const T p2_im = w2_re*a2[1] + w2_im*a2[0];
+        const T p3_re = w3_re*a3[0] - w3_im*a3[1];
+        const T p3_im = w3_re*a3[1] + w3_im*a3[0];
+
+        // first radix-2 stage
+        const T b0_re = a0[0] + p1_re, b0_im = a0[1] + p1_im;
+        const T b1_re = a0[0] - p1_re, b1_im = a0[1] - p1_im;
+        const T b2_re = p2_re + p3_re, b2_im = p2_im + p3_im;
+        const T b3_re = p2_re - p3_re, b3_im = p2_im - p3_im;
+
+        // second radix-2 stage, the twiddle of the odd butterfly is w^h = -i, or i for the inverse transform
+        a0[0] = b0_re + b2_re;
+        a0[1] = b0_im + b2_im;
+        a2[0] = b0_re - b2_re;
+        a2[1] = b0_im - b2_im;
+        if( inverse )
+        {
+            a1[0] = b1_re - b3_im;
+            a1[1] = b1_im + b3_re;
+            a3[0] = b1_re + b3_im;
+            a3[1] = b1_im - b3_re;
+        }
+        else
+        {
+            a1[0] = b1_re + b3_im;
+            a1[1] = b1_im - b3_re;
+            a3[0] = b1_re - b3_im;
+            a3[1] = b1_im + b3_re;
+        }
+    }
 };
 
 
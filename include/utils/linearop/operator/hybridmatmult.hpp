@@ -0,0 +1,357 @@
+///
+/// \file include/utils/linearop/operator/hybridmatmult.hpp
+/// \brief Hybrid dense and sparse Matrix Multiplication class header
+/// \details Provide an explicit operator storing its leading columns densely and the remaining ones as compressed sparse columns and rows.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_OPERATOR_HYBRIDMATMULT_HPP
+#define ASTROQUT_UTILS_OPERATOR_HYBRIDMATMULT_HPP
+
+#include "utils/linearop/matrix/view.hpp"
+#include "utils/linearop/operator.hpp"
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace alias
+{
+
+template <class T = double>
+class HybridMatMult : public Operator<T>
+{
+private:
+    /** Sparse columns stored both as compressed sparse columns and compressed sparse rows
+     */
+    struct Compressed
+    {
+        std::vector<size_t> column_start; //!< Member variable "column_start" first entry of each sparse column, compressed sparse columns
+        std::vector<size_t> column_row; //!< Member variable "column_row" row of each entry, compressed sparse columns
+        std::vector<T> column_value; //!< Member variable "column_value" value of each entry, compressed sparse columns
+        std::vector<size_t> row_start; //!< Member variable "row_start" first entry of each row, compressed sparse rows
+        std::vector<size_t> row_column; //!< Member variable "row_column" sparse column of each entry, compressed sparse rows
+        std::vector<T> row_value; //!< Member variable "row_value" value of each entry, compressed sparse rows
+    };
+
+    size_t dense_width_; //!< Member variable "dense_width_" amount of leading columns stored in data_
+    Shared<Compressed> sparse_; //!< Member variable "sparse_" compressed columns, shared between copies like data_
+
+public:
+    static constexpr T drop_tolerance = std::numeric_limits<T>::epsilon() * 100; //!< Entries of a sparse column below drop_tolerance times its largest entry are round-off and not stored
+
+    /** Default constructor
+     */
+    HybridMatMult()
+        : Operator<T>()
+        , dense_width_(0)
+        , sparse_()
+    {
+#ifdef DEBUG
+        std::cout << "HybridMatMult : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Copy constructor
+     *  \brief The dense and the compressed columns are shared with other, not copied
+     *  \param other Object to copy from
+     */
+    HybridMatMult(const HybridMatMult& other)
+        : Operator<T>(other)
+        , dense_width_(other.dense_width_)
+        , sparse_(other.sparse_)
+    {
+#ifdef DEBUG
+        std::cout << "HybridMatMult : Copy constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Move constructor
+     *  \param other Object to move from
+     */
+    HybridMatMult(HybridMatMult&& other)
+        : HybridMatMult()
+    {
+#ifdef DEBUG
+        std::cout << "HybridMatMult : Move constructor called" << std::endl;
+#endif // DEBUG
+        swap(*this, other);
+    }
+
+    /** Column generator constructor
+     *  \param height Height of the operator
+     *  \param width Width of the operator
+     *  \param dense_width Amount of leading columns to store densely, the other ones are compressed
+     *  \param column Function returning the column of the given index as a height by 1 Matrix, called once per column in order
+     */
+    explicit HybridMatMult(size_t height, size_t width, size_t dense_width, const std::function<Matrix<T>(size_t)>& column)
+        : Operator<T>(dense_width == 0 ? Matrix<T>() : Matrix<T>(height, dense_width), height, width, false)
+        , dense_width_(dense_width)
+        , sparse_()
+    {
+#ifdef DEBUG
+        std::cout << "HybridMatMult : Column generator constructor called with height=" << height << ", width=" << width << ", dense_width=" << dense_width << std::endl;
+#endif // DEBUG
+
+        Matrix<T>& dense = this->data_.Mutable();
+        Compressed sparse;
+        sparse.column_start.assign(1, 0);
+        for(size_t col = 0; col < width; ++col)
+        {
+            Matrix<T> current_column = column(col);
+            if( col < dense_width )
+            {
+                #pragma omp parallel for simd
+                for(size_t row = 0; row < height; ++row)
+                    dense[row*dense_width + col] = current_column[row];
+            }
+            else
+            {
+                T threshold = current_column.Norm(inf) * drop_tolerance;
+                for(size_t row = 0; row < height; ++row)
+                {
+                    if( std::abs(current_column[row]) > threshold )
+                    {
+                        sparse.column_row.push_back(row);
+                        sparse.column_value.push_back(current_column[row]);
+                    }
+                }
+                sparse.column_start.push_back(sparse.column_row.size());
+            }
+        }
+
+        // compressed sparse rows by counting sort of the compressed sparse columns
+        sparse.row_start.assign(height + 1, 0);
+        for(size_t row : sparse.column_row)
+            ++sparse.row_start[row + 1];
+        for(size_t row = 0; row < height; ++row)
+            sparse.row_start[row + 1] += sparse.row_start[row];
+        sparse.row_column.resize(sparse.column_row.size());
+        sparse.row_value.resize(sparse.column_value.size());
+        std::vector<size_t> row_fill(sparse.row_start.begin(), sparse.row_start.end() - 1);
+        for(size_t col = 0; col + 1 < sparse.column_start.size(); ++col)
+        {
+            for(size_t k = sparse.column_start[col]; k < sparse.column_start[col + 1]; ++k)
+            {
+                size_t position = row_fill[sparse.column_row[k]]++;
+                sparse.row_column[position] = col;
+                sparse.row_value[position] = sparse.column_value[k];
+            }
+        }
+        sparse_ = Shared<Compressed>(std::move(sparse));
+    }
+
+    /** Clone function
+     *  \return A copy of the current instance
+     */
+    virtual HybridMatMult* Clone() const override
+    {
+        return new HybridMatMult(*this);
+    }
+
+    /** Default destructor
+     */
+    virtual ~HybridMatMult()
+    {
+#ifdef DEBUG
+        std::cout << "HybridMatMult : Destructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Access dense_width_
+     * \return The amount of columns stored densely
+     */
+    size_t DenseWidth() const noexcept
+    {
+        return dense_width_;
+    }
+
+    /** Amount of stored sparse entries
+     * \return The amount of entries kept in the compressed columns
+     */
+    size_t SparseEntries() const noexcept
+    {
+        return sparse_->column_value.size();
+    }
+
+    /** Memory footprint
+     * \return The amount of bytes used by the dense and the compressed columns and rows
+     */
+    size_t Bytes() const noexcept
+    {
+        return this->data_->Length() * sizeof(T)
+               + (sparse_->column_start.size() + sparse_->row_start.size()) * sizeof(size_t)
+               + 2 * sparse_->column_value.size() * (sizeof(size_t) + sizeof(T));
+    }
+
+    /** Valid instance test
+     *  \return Throws an error message if instance is not valid.
+     */
+    bool IsValid() const override final
+    {
+        if( this->height_ != 0 && this->width_ != 0 && (dense_width_ == 0 || !this->data_->IsEmpty()) )
+            return true;
+        else
+            throw std::invalid_argument("Operator dimensions must be non-zero and dense columns shall not be empty!");
+    }
+
+    /** Swap function
+     *  \param first First object to swap
+     *  \param second Second object to swap
+     */
+    friend void swap(HybridMatMult& first, HybridMatMult& second) noexcept
+    {
+        using std::swap;
+
+        swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
+        swap(first.dense_width_, second.dense_width_);
+        swap(first.sparse_, second.sparse_);
+    }
+
+    /** Copy assignment operator
+     *  \param other Object to assign to current object
+     *  \return A reference to this
+     */
+    HybridMatMult& operator=(HybridMatMult other)
+    {
+        swap(*this, other);
+
+        return *this;
+    }
+
+    Matrix<T> operator*(const Matrix<T>& other) const override final
+    {
+#ifdef DEBUG
+        std::cerr << "HybridMatMult: operator* called" << std::endl;
+#endif // DEBUG
+#ifdef DO_ARGCHECKS
+        try
+        {
+            this->ArgTest(other, mult);
+        }
+        catch (const std::exception&)
+        {
+            throw;
+        }
+#endif // DO_ARGCHECKS
+
+        Matrix<T> result(this->height_, 1);
+        Apply(other, result, Workspace::Local());
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \param in Operand vector
+     *  \param out Result vector, must not overlap in
+     *  \param workspace Scratch memory, unused
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        (void) workspace;
+#ifdef DO_ARGCHECKS
+        if( in.Length() != this->width_ || out.Length() != this->height_ || !out.IsContiguous() )
+            throw std::invalid_argument("Views of Apply do not match the operator dimensions!");
+#endif // DO_ARGCHECKS
+
+        const size_t height = this->transposed_ ? this->width_ : this->height_;
+        const Compressed& sparse = *sparse_;
+        const size_t sparse_width = sparse.column_start.size() - 1;
+
+        if( !this->transposed_ )
+        {
+            // dense columns times the leading coefficients, then gather the sparse columns row by row
+            Matrix<T> result = out.Borrow();
+            if( dense_width_ == 0 )
+                std::fill(out.Data(), out.Data() + height, (T)0);
+            else
+                MatrixVectorMult(*this->data_, in.Segment(0, dense_width_).Borrow(), result);
+            const T* sparse_source = in.Data() + dense_width_;
+            #pragma omp parallel for
+            for(size_t row = 0; row < height; ++row)
+            {
+                T sum = 0;
+                for(size_t k = sparse.row_start[row]; k < sparse.row_start[row + 1]; ++k)
+                    sum += sparse.row_value[k] * sparse_source[sparse.row_column[k]];
+                result[row] += sum;
+            }
+            return;
+        }
+
+        // transposed dense columns as a row vector times matrix product, then gather the sparse columns
+        if( dense_width_ != 0 )
+        {
+            Matrix<T> result_dense = MatrixView<T>(out.Data(), 1, dense_width_).Borrow();
+            VectorMatrixMult(MatrixView<T>(in.Data(), 1, height).Borrow(), *this->data_, result_dense);
+        }
+        #pragma omp parallel for
+        for(size_t col = 0; col < sparse_width; ++col)
+        {
+            T sum = 0;
+            for(size_t k = sparse.column_start[col]; k < sparse.column_start[col + 1]; ++k)
+                sum += sparse.column_value[k] * in[sparse.column_row[k]];
+            out[dense_width_ + col] = sum;
+        }
+    }
+
+    /** Weighted Gram matrix
+     *  \brief Dense block through chunked dot products, blocks involving the sparse columns through their compressed entries only
+     *  \param weights Non-negative weights of the rows, height by 1
+     *  \return The width by width matrix A' * diag(weights) * A
+     */
+    Matrix<T> WeightedGram(const Matrix<T>& weights) const override
+    {
+        if( this->transposed_ )
+            return Operator<T>::WeightedGram(weights);
+
+        const size_t width = this->width_;
+        const Compressed& sparse = *sparse_;
+        const size_t sparse_width = sparse.column_start.size() - 1;
+        Matrix<T> result((T)0, width, width);
+        if( dense_width_ != 0 )
+            this->DenseWeightedGram(this->data_->Data(), this->height_, dense_width_, dense_width_, weights, result.Data(), width);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(size_t col = 0; col < sparse_width; ++col)
+        {
+            T* gram_row = result.Data() + (dense_width_ + col)*width;
+            for(size_t k = sparse.column_start[col]; k < sparse.column_start[col + 1]; ++k)
+            {
+                const size_t row = sparse.column_row[k];
+                const T weighted_value = weights[row] * sparse.column_value[k];
+
+                // sparse column against the dense columns
+                const T* dense_row = this->data_->Data() + row*dense_width_;
+                #pragma omp simd
+                for(size_t j = 0; j < dense_width_; ++j)
+                    gram_row[j] += weighted_value * dense_row[j];
+
+                // sparse column against the previous sparse columns sharing this row
+                for(size_t k_row = sparse.row_start[row]; k_row < sparse.row_start[row + 1]; ++k_row)
+                    if( sparse.row_column[k_row] <= col )
+                        gram_row[dense_width_ + sparse.row_column[k_row]] += weighted_value * sparse.row_value[k_row];
+            }
+        }
+
+        this->SymmetrizeLower(result);
+        return result;
+    }
+
+    /** Transpose in-place
+     *   \brief The storage does not move, the products pick the kernels of the transposed operator
+     *   \return A reference to this
+     */
+    virtual HybridMatMult& Transpose() override
+    {
+        std::swap(this->height_, this->width_);
+        this->transposed_ = !this->transposed_;
+        return *this;
+    }
+
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_OPERATOR_HYBRIDMATMULT_HPP
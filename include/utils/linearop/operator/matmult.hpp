@@ -88,7 +88,7 @@ public:
      */
     bool IsValid() const override final
     {
-        if( this->height_ != 0 && this->width_ != 0 && !this->data_.IsEmpty() )
+        if( this->height_ != 0 && this->width_ != 0 && !this->data_->IsEmpty() )
             return true;
         else
             throw std::invalid_argument("Operator dimensions must be non-zero and function shall not be nullptr!");
@@ -132,17 +132,65 @@ public:
         }
 #endif // DO_ARGCHECKS
 
-        return std::move(this->data_ * other);
+        if( !this->transposed_ )
+            return *this->data_ * other;
+
+        // transposed vector products stream the rows of the storage, the other shapes transpose a copy of it
+        if( other.Width() == 1 && this->height_ != 1 && this->width_ != 1 )
+        {
+            Matrix<T> result(this->height_, 1);
+            VectorMatrixMult(other, *this->data_, result);
+            return result;
+        }
+        return this->data_->Transpose() * other;
+    }
+
+    /** Out-of-place application
+     *  \brief Matrix vector products are written straight into out, as a row vector times the storage once transposed,
+     *  the other shapes go through operator*
+     *  \param in Operand, contiguous
+     *  \param out Result, must not overlap in
+     *  \param workspace Scratch memory, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        if( in.Width() != 1 || !out.IsContiguous() || this->height_ == 1 || this->width_ == 1 )
+            return Operator<T>::Apply(in, out, workspace);
+#ifdef DO_ARGCHECKS
+        if( in.Height() != this->width_ || out.Height() != this->height_ || out.Width() != 1 )
+            throw std::invalid_argument("Views of Apply do not match the operator dimensions!");
+#endif // DO_ARGCHECKS
+
+        Matrix<T> result = out.Borrow();
+        if( !this->transposed_ )
+            MatrixVectorMult(*this->data_, in.Borrow(), result);
+        else
+            VectorMatrixMult(in.Borrow(), *this->data_, result);
+    }
+
+    /** Weighted Gram matrix
+     *  \param weights Non-negative weights of the rows, height by 1
+     *  \return The width by width matrix A' * diag(weights) * A
+     */
+    Matrix<T> WeightedGram(const Matrix<T>& weights) const override
+    {
+        if( this->transposed_ )
+            return Operator<T>::WeightedGram(weights);
+
+        Matrix<T> result((T)0, this->width_, this->width_);
+        this->DenseWeightedGram(this->data_->Data(), this->height_, this->width_, this->width_, weights, result.Data(), this->width_);
+        this->SymmetrizeLower(result);
+        return result;
     }
 
     /** Transpose in-place
+     *   \brief The storage does not move, the products pick the kernels of the transposed operator
      *   \return A reference to this
      */
     virtual MatMult& Transpose() override
     {
         std::swap(this->height_, this->width_);
         this->transposed_ = !this->transposed_;
-        std::move(this->data_).Transpose();
         return *this;
     }
 
@@ -98,13 +98,13 @@ public:
     }
 
     /** Transpose in-place
+     *   \brief The storage does not move, the products pick the kernels of the transposed operator
      *   \return A reference to this
      */
     Spline& Transpose() override final
     {
         std::swap(this->height_, this->width_);
         this->transposed_ = !this->transposed_;
-        this->data_ = std::move(this->data_.Transpose());
         return *this;
     }
 
@@ -0,0 +1,203 @@
+///
+/// \file include/utils/linearop/operator/restrictedoperator.hpp
+/// \brief Restriction of the AstroOperator to a subset of its columns
+/// \details Matrix-free operator acting on the coefficients of a support only, used to refit the non-zero elements.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_OPERATOR_RESTRICTEDOPERATOR_HPP
+#define ASTROQUT_UTILS_OPERATOR_RESTRICTEDOPERATOR_HPP
+
+#include "utils/linearop/operator/astrooperator.hpp"
+
+namespace alias
+{
+
+template<class T = double>
+class RestrictedOperator : public Operator<T>
+{
+private:
+    AstroOperator<T> astro_; //!< Member variable "astro_" full operator, transposed along with this
+    Matrix<size_t> support_; //!< Member variable "support_" increasing indices of the kept columns of astro_
+
+public:
+    /** Default constructor
+     */
+    RestrictedOperator()
+        : Operator<T>()
+        , astro_()
+        , support_()
+    {
+#ifdef DEBUG
+        std::cout << "RestrictedOperator : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Copy constructor
+     *  \param other Object to copy from
+     */
+    RestrictedOperator(const RestrictedOperator& other)
+        : Operator<T>(other)
+        , astro_(other.astro_)
+        , support_(other.support_)
+    {
+#ifdef DEBUG
+        std::cout << "RestrictedOperator : Copy constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Move constructor
+     *  \param other Object to move from
+     */
+    RestrictedOperator(RestrictedOperator&& other)
+        : RestrictedOperator()
+    {
+#ifdef DEBUG
+        std::cout << "RestrictedOperator : Move constructor called" << std::endl;
+#endif // DEBUG
+        swap(*this, other);
+    }
+
+    /** Full member constructor
+     *  \param astro Full operator, not transposed
+     *  \param support Increasing indices of the columns of astro to keep
+     *  \param transposed Transpose the restricted operator
+     */
+    explicit RestrictedOperator(const AstroOperator<T>& astro,
+                                const Matrix<size_t>& support,
+                                bool transposed = false)
+        : Operator<T>(Matrix<T>(),
+                      transposed ? support.Length() : astro.PicSize()*astro.PicSize(),
+                      transposed ? astro.PicSize()*astro.PicSize() : support.Length(),
+                      transposed)
+        , astro_(astro)
+        , support_(support)
+    {
+#ifdef DEBUG
+        std::cout << "RestrictedOperator : Full member constructor called" << std::endl;
+#endif // DEBUG
+        if( transposed )
+            astro_.Transpose();
+    }
+
+    /** Clone function
+     *  \return A copy of the current instance
+     */
+    RestrictedOperator* Clone() const override final
+    {
+        return new RestrictedOperator(*this);
+    }
+
+    /** Default destructor
+     */
+    virtual ~RestrictedOperator()
+    {
+#ifdef DEBUG
+        std::cout << "RestrictedOperator : Destructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    Matrix<size_t> Support() const
+    {
+        return support_;
+    }
+
+    /** Valid instance test
+     *  \return Throws an error message if instance is not valid.
+     */
+    bool IsValid() const override final
+    {
+        if( this->height_ != 0 && this->width_ != 0 && !support_.IsEmpty() )
+            return true;
+        else
+            throw std::invalid_argument("Operator dimensions must be non-zero and support shall not be empty!");
+    }
+
+    /** Transpose in-place
+     *  \return A reference to this
+     */
+    RestrictedOperator& Transpose() override final
+    {
+        this->transposed_ = !this->transposed_;
+        std::swap(this->height_, this->width_);
+        astro_.Transpose();
+        return *this;
+    }
+
+    /** Swap function
+     *  \param first First object to swap
+     *  \param second Second object to swap
+     */
+    friend void swap(RestrictedOperator& first, RestrictedOperator& second) noexcept
+    {
+        using std::swap;
+
+        swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
+        swap(first.astro_, second.astro_);
+        swap(first.support_, second.support_);
+    }
+
+    /** Copy assignment operator
+     *  \param other Object to assign to current object
+     *  \return A reference to this
+     */
+    RestrictedOperator& operator=(RestrictedOperator other)
+    {
+        swap(*this, other);
+
+        return *this;
+    }
+
+    virtual Matrix<T> operator*(const Matrix<T>& other) const override final
+    {
+#ifdef DO_ARGCHECKS
+        try
+        {
+            this->ArgTest(other, mult);
+        }
+        catch (const std::exception&)
+        {
+            throw;
+        }
+#endif // DO_ARGCHECKS
+        Matrix<T> result(this->height_, 1);
+        Apply(other, result, Workspace::Local());
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \param in Coefficients of the support, or picture vector if transposed
+     *  \param out Picture vector, or coefficients of the support if transposed, contiguous and not overlapping in
+     *  \param workspace Scratch memory for the full model vector, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+        Workspace::Frame frame(workspace);
+        const size_t model_size = (astro_.PicSize()+2)*astro_.PicSize();
+        MatrixView<T> full(workspace.Allocate<T>(model_size), model_size, 1);
+
+        if( !this->transposed_ )
+        {
+            // scatter the coefficients into the model layout, then B * A * W
+            std::fill(full.Data(), full.Data() + model_size, (T)0);
+            #pragma omp parallel for simd
+            for(size_t i = 0; i < support_.Length(); ++i)
+                full[support_[i]] = in[i];
+            astro_.BAW(full, out, workspace);
+            return;
+        }
+
+        // W' * A' * B', then gather the coefficients of the support
+        astro_.WtAtBt(in, full, workspace);
+        #pragma omp parallel for simd
+        for(size_t i = 0; i < support_.Length(); ++i)
+            out[i] = full[support_[i]];
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_OPERATOR_RESTRICTEDOPERATOR_HPP
@@ -0,0 +1,355 @@
+///
+/// \file include/utils/linearop/operator/separableconvolution.hpp
+/// \brief Separable convolution class header
+/// \details Provide a convolution operator with a filter approximated by a sum of separable rank one filters
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_OPERATOR_SEPARABLECONVOLUTION_HPP
+#define ASTROQUT_UTILS_OPERATOR_SEPARABLECONVOLUTION_HPP
+
+#include "utils/linearop/matrix/view.hpp"
+#include "utils/linearop/operator.hpp"
+
+#include <vector>
+
+namespace alias
+{
+
+template <class T = double>
+class SeparableConvolution : public Operator<T>
+{
+private:
+    /** Rank one terms of the filter
+     *  \brief The filter is approximated by the sum over the terms of columns(term, i) * rows(term, j)
+     */
+    struct Factors
+    {
+        Matrix<T> columns; //!< Member variable "columns" vertical filters scaled by their singular value, rank by filter height
+        Matrix<T> rows; //!< Member variable "rows" horizontal filters, rank by filter width
+        double error = 0; //!< Member variable "error" Frobenius norm of the dropped terms relative to the one of the filter
+    };
+
+    Shared<Factors> factors_; //!< Member variable "factors_" rank one terms shared between copies
+
+public:
+
+    /** Default constructor
+     */
+    SeparableConvolution()
+        : Operator<T>()
+        , factors_()
+    {
+#ifdef DEBUG
+        std::cout << "SeparableConvolution : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Copy constructor
+     *  \brief The rank one terms are shared with other, not copied
+     *  \param other Object to copy from
+     */
+    SeparableConvolution(const SeparableConvolution& other)
+        : Operator<T>(other)
+        , factors_(other.factors_)
+    {
+#ifdef DEBUG
+        std::cout << "SeparableConvolution : Copy constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Move constructor
+     *  \param other Object to move from
+     */
+    SeparableConvolution(SeparableConvolution&& other)
+        : SeparableConvolution()
+    {
+#ifdef DEBUG
+        std::cout << "SeparableConvolution : Move constructor called" << std::endl;
+#endif // DEBUG
+        swap(*this, other);
+    }
+
+    /** Build constructor
+     *  \brief Keeps the leading terms of the singular value decomposition of the filter until the Frobenius norm of
+     *  the dropped ones is at most tolerance times the one of the filter
+     *  \param filter Matrix containing the filter's data, with odd dimensions. Needs to be already inverted if not symmetrical.
+     *  \param tolerance Relative error allowed on the filter, 0 keeps every non-zero term
+     */
+    explicit SeparableConvolution(const Matrix<T>& filter, double tolerance)
+        : Operator<T>(Matrix<T>(), filter.Height(), filter.Width(), false)
+        , factors_()
+    {
+#ifdef DEBUG
+        std::cout << "SeparableConvolution : Build constructor called with tolerance=" << tolerance << std::endl;
+#endif // DEBUG
+#ifdef DO_ARGCHECKS
+        if( this->height_ % 2 != 1 || this->width_ % 2 != 1 )
+            throw std::invalid_argument("The filter size for the convolution needs to be odd in both dimensions.");
+        if( tolerance < 0 )
+            throw std::invalid_argument("The tolerance of the separable approximation can not be negative.");
+#endif // DO_ARGCHECKS
+
+        const size_t height = filter.Height();
+        const size_t width = filter.Width();
+        std::vector<double> left(filter.Data(), filter.Data() + filter.Length());
+        std::vector<double> right(width*width, 0.0);
+        std::vector<double> singular_values(width);
+        Decompose(left.data(), right.data(), singular_values.data(), height, width);
+
+        // leading terms first
+        std::vector<size_t> order(width);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t first, size_t second){ return singular_values[first] > singular_values[second]; });
+
+        double total = 0;
+        for( size_t term = 0; term < width; ++term )
+            total += singular_values[term]*singular_values[term];
+        size_t rank = width;
+        double dropped = 0;
+        while( rank > 0 && singular_values[order[rank-1]] == 0 )
+            --rank;
+        while( rank > 1 && dropped + singular_values[order[rank-1]]*singular_values[order[rank-1]] <= tolerance*tolerance*total )
+        {
+            dropped += singular_values[order[rank-1]]*singular_values[order[rank-1]];
+            --rank;
+        }
+
+        Factors factors;
+        factors.columns = Matrix<T>(rank, height);
+        factors.rows = Matrix<T>(rank, width);
+        for( size_t term = 0; term < rank; ++term )
+        {
+            for( size_t i = 0; i < height; ++i )
+                factors.columns[term*height + i] = (T) left[i*width + order[term]];
+            for( size_t j = 0; j < width; ++j )
+                factors.rows[term*width + j] = (T) right[j*width + order[term]];
+        }
+        factors.error = total == 0 ? 0 : std::sqrt(dropped / total);
+        factors_ = std::move(factors);
+    }
+
+    /** Clone function
+     *  \return A copy of the current instance
+     */
+    SeparableConvolution* Clone() const override final
+    {
+        return new SeparableConvolution(*this);
+    }
+
+    /** Default destructor
+     */
+    virtual ~SeparableConvolution()
+    {
+#ifdef DEBUG
+        std::cout << "SeparableConvolution : Destructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Valid instance test
+     *  \return Throws an error message if instance is not valid.
+     */
+    bool IsValid() const override final
+    {
+        if( this->height_ != 0 && this->width_ != 0 && this->height_ % 2 == 1 && this->width_ % 2 == 1 && !factors_->columns.IsEmpty() )
+            return true;
+        else
+            throw std::invalid_argument("Convolution dimensions must be non-zero and odd, and the filter shall be decomposed!");
+    }
+
+    /** Access the rank
+     *  \return The amount of separable terms kept
+     */
+    size_t Rank() const noexcept
+    {
+        return factors_->columns.Height();
+    }
+
+    /** Access the error
+     *  \return The Frobenius norm of the difference between the filter and its approximation, relative to the one of the filter
+     */
+    double Error() const noexcept
+    {
+        return factors_->error;
+    }
+
+    /** Swap function
+     *  \param first First object to swap
+     *  \param second Second object to swap
+     */
+    friend void swap(SeparableConvolution& first, SeparableConvolution& second) noexcept
+    {
+        using std::swap;
+
+        swap(static_cast<Operator<T>&>(first), static_cast<Operator<T>&>(second));
+        swap(first.factors_, second.factors_);
+    }
+
+    /** Copy assignment operator
+     *  \param other Object to assign to current object
+     *  \return A reference to this
+     */
+    SeparableConvolution& operator=(SeparableConvolution other)
+    {
+        swap(*this, other);
+
+        return *this;
+    }
+
+    Matrix<T> operator*(const Matrix<T>& other) const override final
+    {
+#ifdef DEBUG
+        std::cerr << "SeparableConvolution: operator* called" << std::endl;
+#endif // DEBUG
+#ifdef DO_ARGCHECKS
+        if( !IsValid() || !other.IsValid() )
+            throw std::invalid_argument("Can not perform a convolution with these Matrices.");
+#endif // DO_ARGCHECKS
+
+        Matrix<T> result(other.Height(), other.Width());
+        Apply(other, result, Workspace::Local());
+
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \brief Every term filters the rows of the picture, then the columns of that intermediate into out.
+     *  Both passes add shifted rows, so that the columns are vectorized.
+     *  \param in Picture to convolve
+     *  \param out Result of the same size as in, not overlapping in
+     *  \param workspace Scratch memory for the horizontally filtered picture, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+#ifdef DO_ARGCHECKS
+        if( in.Height() != out.Height() || in.Width() != out.Width() )
+            throw std::invalid_argument("Views of Apply must have the same size!");
+#endif // DO_ARGCHECKS
+        Workspace::Frame frame(workspace);
+
+        const size_t height = in.Height();
+        const size_t width = in.Width();
+        const size_t filter_height = this->height_;
+        const size_t filter_width = this->width_;
+        const size_t height_dist_from_center = (filter_height - 1) / 2;
+        const size_t width_dist_from_center = (filter_width - 1) / 2;
+        const Factors& factors = *factors_;
+        T* temp = workspace.Allocate<T>(height*width);
+
+        #pragma omp parallel for
+        for( size_t row = 0; row < height; ++row )
+            std::fill(out.Data() + row*out.Stride(), out.Data() + row*out.Stride() + width, (T)0);
+
+        for( size_t term = 0; term < Rank(); ++term )
+        {
+            const T* horizontal = factors.rows.Data() + term*filter_width;
+            const T* vertical = factors.columns.Data() + term*filter_height;
+
+            // temp(row, col) = sum_j horizontal[j] * in(row, col + j - width_dist_from_center)
+            #pragma omp parallel for
+            for( size_t row = 0; row < height; ++row )
+            {
+                const T* in_row = in.Data() + row*in.Stride();
+                T* temp_row = temp + row*width;
+                std::fill(temp_row, temp_row + width, (T)0);
+                for( size_t j = 0; j < filter_width; ++j )
+                {
+                    const T factor = horizontal[j];
+                    const size_t col_begin = j < width_dist_from_center ? width_dist_from_center - j : 0;
+                    const size_t col_end = width + width_dist_from_center > j ? std::min(width, width + width_dist_from_center - j) : 0;
+                    #pragma omp simd
+                    for( size_t col = col_begin; col < col_end; ++col )
+                        temp_row[col] += factor * in_row[col + j - width_dist_from_center];
+                }
+            }
+
+            // out(row, col) += sum_i vertical[i] * temp(row + i - height_dist_from_center, col)
+            #pragma omp parallel for
+            for( size_t row = 0; row < height; ++row )
+            {
+                T* out_row = out.Data() + row*out.Stride();
+                const size_t i_begin = row < height_dist_from_center ? height_dist_from_center - row : 0;
+                const size_t i_end = std::min(filter_height, height + height_dist_from_center - row);
+                for( size_t i = i_begin; i < i_end; ++i )
+                {
+                    const T factor = vertical[i];
+                    const T* temp_row = temp + (row + i - height_dist_from_center)*width;
+                    #pragma omp simd
+                    for( size_t col = 0; col < width; ++col )
+                        out_row[col] += factor * temp_row[col];
+                }
+            }
+        }
+    }
+
+private:
+    /** One-sided Jacobi singular value decomposition
+     *  \brief Rotates pairs of columns of left until they are orthogonal, the rotations are accumulated in right.
+     *  Then left = U * diag(singular_values) and the matrix is left * right'.
+     *  \param left Matrix to decompose, height by width, replaced by its left singular vectors scaled by the singular values
+     *  \param right Width by width, replaced by the right singular vectors
+     *  \param singular_values Width singular values, unsorted
+     *  \param height Height of the matrix
+     *  \param width Width of the matrix
+     */
+    static void Decompose(double* left, double* right, double* singular_values, size_t height, size_t width)
+    {
+        for( size_t i = 0; i < width; ++i )
+            right[i*width + i] = 1.0;
+
+        constexpr size_t sweep_max = 64;
+        bool rotated = true;
+        for( size_t sweep = 0; sweep < sweep_max && rotated; ++sweep )
+        {
+            rotated = false;
+            for( size_t p = 0; p + 1 < width; ++p )
+                for( size_t q = p + 1; q < width; ++q )
+                {
+                    double alpha = 0, beta = 0, gamma = 0;
+                    for( size_t i = 0; i < height; ++i )
+                    {
+                        alpha += left[i*width + p] * left[i*width + p];
+                        beta += left[i*width + q] * left[i*width + q];
+                        gamma += left[i*width + p] * left[i*width + q];
+                    }
+                    if( std::abs(gamma) <= std::numeric_limits<double>::epsilon() * std::sqrt(alpha*beta) )
+                        continue;
+                    rotated = true;
+
+                    double zeta = (beta - alpha) / (2*gamma);
+                    double tangent = (zeta < 0 ? -1.0 : 1.0) / (std::abs(zeta) + std::sqrt(1 + zeta*zeta));
+                    double cosine = 1 / std::sqrt(1 + tangent*tangent);
+                    double sine = cosine * tangent;
+                    for( size_t i = 0; i < height; ++i )
+                    {
+                        double first = left[i*width + p];
+                        double second = left[i*width + q];
+                        left[i*width + p] = cosine*first - sine*second;
+                        left[i*width + q] = sine*first + cosine*second;
+                    }
+                    for( size_t i = 0; i < width; ++i )
+                    {
+                        double first = right[i*width + p];
+                        double second = right[i*width + q];
+                        right[i*width + p] = cosine*first - sine*second;
+                        right[i*width + q] = sine*first + cosine*second;
+                    }
+                }
+        }
+
+        for( size_t j = 0; j < width; ++j )
+        {
+            double norm = 0;
+            for( size_t i = 0; i < height; ++i )
+                norm += left[i*width + j] * left[i*width + j];
+            singular_values[j] = std::sqrt(norm);
+        }
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_OPERATOR_SEPARABLECONVOLUTION_HPP
@@ -177,22 +177,37 @@ public:
 #endif // DO_ARGCHECKS
 
         Matrix<T> result( other.Height(), other.Width() );
-        T* temp_1 = new T[other.Height()];
-        T* temp_2 = new T[other.Height()];
+        Apply(other, result, Workspace::Local());
 
+        return result;
+    }
+
+    /** Out-of-place application
+     *  \brief Transforms the first column of in, the intermediate arrays are taken from the workspace
+     *  \param in Signal or wavelet coefficients, contiguous
+     *  \param out Result of the same size as in, contiguous and not overlapping in
+     *  \param workspace Scratch memory, left as it was found
+     */
+    void Apply(const MatrixView<T>& in, MatrixView<T> out, Workspace& workspace) const override final
+    {
+#ifdef DO_ARGCHECKS
+        if( in.Height() != out.Height() || in.Width() != out.Width() )
+            throw std::invalid_argument("Views of Apply must have the same size!");
+#endif // DO_ARGCHECKS
+        Workspace::Frame frame(workspace);
+        T* temp_1 = workspace.Allocate<T>(in.Height());
+        T* temp_2 = workspace.Allocate<T>(in.Height());
+
+        const Matrix<T> signal = in.Borrow();
+        Matrix<T> result = out.Borrow();
         if(!this->transposed_)
         {
-            IWT_PO(other, result, 0, 0, temp_1, temp_2);
+            IWT_PO(signal, result, 0, 0, temp_1, temp_2);
         }
         else
         {
-            FWT_PO(other, result, 0, 0, temp_1, temp_2);
+            FWT_PO(signal, result, 0, 0, temp_1, temp_2);
         }
-
-        delete[] temp_1;
-        delete[] temp_2;
-
-        return result;
     }
 
     /** Transpose in-place
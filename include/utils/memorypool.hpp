@@ -0,0 +1,277 @@
+///
+/// \file include/utils/memorypool.hpp
+/// \brief Memory pool header
+/// \details Provide an aligned, size-bucketed memory pool recycling Matrix buffers.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_MEMORYPOOL_HPP
+#define ASTROQUT_UTILS_MEMORYPOOL_HPP
+
+#include "const.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifndef __unix__
+#include <malloc.h>
+#endif // __unix__
+
+namespace alias
+{
+
+class MemoryPool
+{
+public:
+    static constexpr size_t alignment = 64; //!< Alignment of every buffer, one cache line
+
+private:
+    /** Block header, stored in the cache line right before the user data
+     */
+    struct Header
+    {
+        size_t bytes; //!< Member variable "bytes" usable size of the block
+    };
+
+    std::mutex mutex_; //!< Member variable "mutex_"
+    std::unordered_map<size_t, std::vector<void*>> free_blocks_; //!< Member variable "free_blocks_" recycled blocks by size
+    size_t scope_depth_; //!< Member variable "scope_depth_" amount of open recycling scopes
+    size_t cached_bytes_; //!< Member variable "cached_bytes_" bytes currently held in free_blocks_
+    size_t cached_bytes_max_; //!< Member variable "cached_bytes_max_" upper bound of cached_bytes_
+    size_t allocations_; //!< Member variable "allocations_" amount of requested blocks
+    size_t allocations_avoided_; //!< Member variable "allocations_avoided_" amount of requests served from the cache
+
+    /** Default constructor
+     */
+    MemoryPool() noexcept
+        : mutex_()
+        , free_blocks_()
+        , scope_depth_(0)
+        , cached_bytes_(0)
+        , cached_bytes_max_((size_t)1 << 30)
+        , allocations_(0)
+        , allocations_avoided_(0)
+    {
+#ifdef DEBUG
+        std::cout << "MemoryPool : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Round a size up to the next multiple of the alignment
+     *  \param bytes Size to round
+     *  \return The rounded size
+     */
+    static size_t RoundUp(size_t bytes) noexcept
+    {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    /** Allocate a raw aligned block from the system, header included
+     *  \param bytes Usable size of the block, multiple of the alignment
+     *  \return A pointer to the usable part of the block
+     */
+    static void* SystemAllocate(size_t bytes)
+    {
+#ifdef __unix__
+        char* block = static_cast<char*>(std::aligned_alloc(alignment, bytes + alignment));
+#else
+        char* block = static_cast<char*>(_aligned_malloc(bytes + alignment, alignment));
+#endif // __unix__
+        if( block == nullptr )
+            throw std::bad_alloc();
+
+        reinterpret_cast<Header*>(block)->bytes = bytes;
+        return block + alignment;
+    }
+
+    /** Give a block back to the system
+     *  \param ptr Pointer to the usable part of the block
+     */
+    static void SystemFree(void* ptr) noexcept
+    {
+#ifdef __unix__
+        std::free(static_cast<char*>(ptr) - alignment);
+#else
+        _aligned_free(static_cast<char*>(ptr) - alignment);
+#endif // __unix__
+    }
+
+    /** Release every cached block, mutex must be held by the caller
+     */
+    void ReleaseCache() noexcept
+    {
+        for( auto& bucket : free_blocks_ )
+            for( void* ptr : bucket.second )
+                SystemFree(ptr);
+        free_blocks_.clear();
+        cached_bytes_ = 0;
+    }
+
+public:
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    /** Default destructor
+     */
+    ~MemoryPool()
+    {
+#ifdef DEBUG
+        std::cout << "MemoryPool : Destructor called" << std::endl;
+#endif // DEBUG
+        ReleaseCache();
+    }
+
+    /** Process-wide instance
+     *  \return A reference to the pool shared by every Matrix
+     */
+    static MemoryPool& Instance()
+    {
+        static MemoryPool pool;
+        return pool;
+    }
+
+    /** Allocate an aligned block
+     *  \brief Serves the request from the cache if a block of the same size was released inside an open scope
+     *  \param bytes Requested size in bytes
+     *  \return A pointer aligned on MemoryPool::alignment
+     */
+    void* Allocate(size_t bytes)
+    {
+        bytes = RoundUp(bytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++allocations_;
+            auto bucket = free_blocks_.find(bytes);
+            if( bucket != free_blocks_.end() && !bucket->second.empty() )
+            {
+                void* ptr = bucket->second.back();
+                bucket->second.pop_back();
+                cached_bytes_ -= bytes;
+                ++allocations_avoided_;
+                return ptr;
+            }
+        }
+        return SystemAllocate(bytes);
+    }
+
+    /** Release an aligned block
+     *  \brief Keeps the block for later reuse if a scope is open and the cache is not full, frees it otherwise
+     *  \param ptr Pointer obtained from Allocate, can be nullptr
+     */
+    void Deallocate(void* ptr) noexcept
+    {
+        if( ptr == nullptr )
+            return;
+
+        size_t bytes = reinterpret_cast<Header*>(static_cast<char*>(ptr) - alignment)->bytes;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if( scope_depth_ != 0 && cached_bytes_ + bytes <= cached_bytes_max_ )
+            {
+                free_blocks_[bytes].push_back(ptr);
+                cached_bytes_ += bytes;
+                return;
+            }
+        }
+        SystemFree(ptr);
+    }
+
+    /** Open a recycling scope
+     *  \brief Released blocks are cached until the outermost scope is closed
+     */
+    void OpenScope() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++scope_depth_;
+    }
+
+    /** Close a recycling scope
+     *  \brief Frees every cached block when the outermost scope is closed
+     */
+    void CloseScope() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if( scope_depth_ != 0 && --scope_depth_ == 0 )
+            ReleaseCache();
+    }
+
+    /** Access cached_bytes_max_
+     * \return The current value of cached_bytes_max_
+     */
+    size_t CachedBytesMax() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cached_bytes_max_;
+    }
+    /** Set cached_bytes_max_
+     * \param val New value to set, 0 disables recycling
+     */
+    void CachedBytesMax(size_t val) noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cached_bytes_max_ = val;
+    }
+
+    /** Access allocations_
+     * \return The amount of blocks requested since the last counter reset
+     */
+    size_t Allocations() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_;
+    }
+
+    /** Access allocations_avoided_
+     * \return The amount of requests served from the cache since the last counter reset
+     */
+    size_t AllocationsAvoided() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_avoided_;
+    }
+
+    /** Reset the allocation counters
+     */
+    void ResetCounters() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        allocations_ = 0;
+        allocations_avoided_ = 0;
+    }
+
+    /** RAII recycling scope
+     *  \brief Buffers released while a Scope is alive are recycled for later Matrix allocations
+     */
+    class Scope
+    {
+    public:
+        /** Default constructor
+         */
+        Scope() noexcept
+        {
+            MemoryPool::Instance().OpenScope();
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        /** Default destructor
+         */
+        ~Scope()
+        {
+            MemoryPool::Instance().CloseScope();
+        }
+    };
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_MEMORYPOOL_HPP
@@ -0,0 +1,258 @@
+///
+/// \file include/utils/reduction.hpp
+/// \brief Reduction kernels header
+/// \details Provide vectorized reductions with several independent accumulators, and a fused multi-reduction.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_REDUCTION_HPP
+#define ASTROQUT_UTILS_REDUCTION_HPP
+
+#include "const.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <omp.h>
+
+namespace alias
+{
+namespace reduction
+{
+
+inline constexpr size_t accumulators = 32; //!< Independent partial results of a single reduction, four AVX-512 or eight AVX2 double vectors to hide the add latency
+inline constexpr size_t fused_accumulators = 16; //!< Independent partial results of each quantity of a fused reduction, fewer to stay within the vector registers
+inline constexpr size_t parallel_min_length = (size_t)1 << 15; //!< Shorter ranges are reduced by the calling thread only
+
+/** Split a reduction among the threads
+ *  \brief Every thread reduces one contiguous chunk, the partial results are combined in thread order so that
+ *  the result only depends on the amount of threads
+ *  \param length Amount of elements to reduce
+ *  \param identity Neutral element of combine
+ *  \param range Functor reducing the elements [begin, end) to a single Result
+ *  \param combine Functor combining two Result
+ *  \return The reduction of all elements
+ */
+template <class Result, class Range, class Combine>
+Result Parallel(size_t length, Result identity, Range range, Combine combine)
+{
+    if( length < parallel_min_length || omp_get_max_threads() == 1 )
+        return range(0, length);
+
+    std::vector<Result> partial(omp_get_max_threads(), identity);
+    #pragma omp parallel
+    {
+        size_t thread = omp_get_thread_num();
+        size_t chunk = (length / omp_get_num_threads() + accumulators - 1) / accumulators * accumulators;
+        size_t begin = std::min(length, thread * chunk);
+        size_t end = thread + 1 == (size_t) omp_get_num_threads() ? length : std::min(length, begin + chunk);
+        partial[thread] = range(begin, end);
+    }
+
+    Result result = identity;
+    for( const Result& value : partial )
+        result = combine(result, value);
+    return result;
+}
+
+/** Reduce a range with several independent accumulators
+ *  \brief Consecutive elements go to different accumulators, so that the loop carries no dependency
+ *  from one element to the next and vectorizes over the accumulators
+ *  \param begin First element to reduce
+ *  \param end Element after the last one to reduce
+ *  \param identity Neutral element of combine
+ *  \param load Functor returning the element of the given index, converted to Acc
+ *  \param combine Functor combining two Acc
+ *  \return The reduction of the range
+ */
+template <class Acc, class Load, class Combine>
+Acc ReduceRange(size_t begin, size_t end, Acc identity, Load load, Combine combine)
+{
+    Acc partial[accumulators];
+    for(size_t j = 0; j < accumulators; ++j)
+        partial[j] = identity;
+
+    size_t i = begin;
+    for(; i + accumulators <= end; i += accumulators)
+    {
+        #pragma omp simd
+        for(size_t j = 0; j < accumulators; ++j)
+            partial[j] = combine(partial[j], load(i + j));
+    }
+    // remaining elements in order, ranges shorter than the accumulators are reduced sequentially
+    for(; i < end; ++i)
+        partial[0] = combine(partial[0], load(i));
+
+    // pairwise combination of the accumulators
+    for(size_t width = accumulators/2; width > 0; width /= 2)
+        for(size_t j = 0; j < width; ++j)
+            partial[j] = combine(partial[j], partial[j + width]);
+    return partial[0];
+}
+
+/** Multi-accumulator, multi-threaded reduction
+ *  \param length Amount of elements to reduce
+ *  \param identity Neutral element of combine
+ *  \param load Functor returning the element of the given index, converted to Acc
+ *  \param combine Functor combining two Acc
+ *  \return The reduction of all elements
+ */
+template <class Acc, class Load, class Combine>
+Acc Reduce(size_t length, Acc identity, Load load, Combine combine)
+{
+    return Parallel(length,
+                    identity,
+                    [&](size_t begin, size_t end){ return ReduceRange(begin, end, identity, load, combine); },
+                    combine);
+}
+
+/** Sum of the elements
+ *  \param length Amount of elements
+ *  \param load Functor returning the element of the given index
+ *  \return The sum of type Acc
+ */
+template <class Acc, class Load>
+Acc Sum(size_t length, Load load)
+{
+    return Reduce<Acc>(length, Acc(0), load, [](Acc first, Acc second){ return first + second; });
+}
+
+/** Smallest element
+ *  \param length Amount of elements
+ *  \param load Functor returning the element of the given index
+ *  \return The smallest element, the largest representable value if length is 0
+ */
+template <class Acc, class Load>
+Acc Min(size_t length, Load load)
+{
+    Acc identity = std::numeric_limits<Acc>::has_infinity ? std::numeric_limits<Acc>::infinity() : std::numeric_limits<Acc>::max();
+    return Reduce<Acc>(length, identity, load, [](Acc first, Acc second){ return std::min(first, second); });
+}
+
+/** Largest element
+ *  \param length Amount of elements
+ *  \param load Functor returning the element of the given index
+ *  \return The largest element, the lowest representable value if length is 0
+ */
+template <class Acc, class Load>
+Acc Max(size_t length, Load load)
+{
+    Acc identity = std::numeric_limits<Acc>::has_infinity ? -std::numeric_limits<Acc>::infinity() : std::numeric_limits<Acc>::lowest();
+    return Reduce<Acc>(length, identity, load, [](Acc first, Acc second){ return std::max(first, second); });
+}
+
+/** Result of the fused reduction
+ */
+struct Summary
+{
+    double sum; //!< Member variable "sum"
+    double norm_one; //!< Member variable "norm_one" sum of the absolute values
+    double norm_two_squared; //!< Member variable "norm_two_squared" sum of the squares
+    double min; //!< Member variable "min"
+    double max; //!< Member variable "max"
+
+    /** Infinity norm
+     *  \return The largest absolute value
+     */
+    double NormInf() const noexcept
+    {
+        return std::max(std::abs(min), std::abs(max));
+    }
+};
+
+/** Summary of no element
+ *  \return The neutral element of Merge
+ */
+inline Summary EmptySummary() noexcept
+{
+    return Summary{0.0, 0.0, 0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+}
+
+/** Combine two partial summaries
+ */
+inline Summary Merge(const Summary& first, const Summary& second) noexcept
+{
+    return Summary{first.sum + second.sum,
+                   first.norm_one + second.norm_one,
+                   first.norm_two_squared + second.norm_two_squared,
+                   std::min(first.min, second.min),
+                   std::max(first.max, second.max)};
+}
+
+/** Fused reduction of a range
+ *  \brief Sum, one norm, squared two norm, min and max in a single sweep, each with its own independent accumulators
+ *  \param begin First element to reduce
+ *  \param end Element after the last one to reduce
+ *  \param load Functor returning the element of the given index, converted to double
+ *  \return The summary of the range
+ */
+template <class Load>
+Summary SummarizeRange(size_t begin, size_t end, Load load)
+{
+    double sum[fused_accumulators];
+    double norm_one[fused_accumulators];
+    double norm_two_squared[fused_accumulators];
+    double min[fused_accumulators];
+    double max[fused_accumulators];
+    for(size_t j = 0; j < fused_accumulators; ++j)
+    {
+        sum[j] = 0.0;
+        norm_one[j] = 0.0;
+        norm_two_squared[j] = 0.0;
+        min[j] = std::numeric_limits<double>::infinity();
+        max[j] = -std::numeric_limits<double>::infinity();
+    }
+
+    size_t i = begin;
+    for(; i + fused_accumulators <= end; i += fused_accumulators)
+    {
+        #pragma omp simd
+        for(size_t j = 0; j < fused_accumulators; ++j)
+        {
+            double value = load(i + j);
+            sum[j] += value;
+            norm_one[j] += std::abs(value);
+            norm_two_squared[j] += value * value;
+            min[j] = std::min(min[j], value);
+            max[j] = std::max(max[j], value);
+        }
+    }
+    for(; i < end; ++i)
+    {
+        double value = load(i);
+        sum[0] += value;
+        norm_one[0] += std::abs(value);
+        norm_two_squared[0] += value * value;
+        min[0] = std::min(min[0], value);
+        max[0] = std::max(max[0], value);
+    }
+
+    Summary result = EmptySummary();
+    for(size_t j = 0; j < fused_accumulators; ++j)
+        result = Merge(result, Summary{sum[j], norm_one[j], norm_two_squared[j], min[j], max[j]});
+    return result;
+}
+
+/** Fused multi-threaded reduction
+ *  \param length Amount of elements to reduce
+ *  \param load Functor returning the element of the given index, converted to double
+ *  \return The summary of all elements
+ */
+template <class Load>
+Summary Summarize(size_t length, Load load)
+{
+    return Parallel(length,
+                    EmptySummary(),
+                    [&](size_t begin, size_t end){ return SummarizeRange(begin, end, load); },
+                    Merge);
+}
+
+} // namespace reduction
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_REDUCTION_HPP
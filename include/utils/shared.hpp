@@ -0,0 +1,110 @@
+///
+/// \file include/utils/shared.hpp
+/// \brief Shared state header
+/// \details Provide a reference-counted handle to immutable state with copy-on-write.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_SHARED_HPP
+#define ASTROQUT_UTILS_SHARED_HPP
+
+#include "const.hpp"
+
+#include <iostream>
+#include <memory>
+#include <utility>
+
+namespace alias
+{
+
+/** Handle to a value shared between copies
+ *  \brief Copies of the handle point to the same value, only Mutable gives write access and it detaches
+ *  the handle from the other copies first. Detaching is not synchronized with concurrent copies of the same handle.
+ */
+template<class M>
+class Shared
+{
+private:
+    std::shared_ptr<M> value_; //!< Member variable "value_" never nullptr
+
+    /** Value shared by every default constructed handle
+     *  \return A pointer to a default constructed value
+     */
+    static const std::shared_ptr<M>& Empty()
+    {
+        static const std::shared_ptr<M> empty = std::make_shared<M>();
+        return empty;
+    }
+
+public:
+    /** Default constructor
+     *  Points to a default constructed value without allocating
+     */
+    Shared()
+        : value_(Empty())
+    {
+#ifdef DEBUG
+        std::cout << "Shared : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Value constructor
+     *  \param value Value to hold, moved into shared storage
+     */
+    Shared(M value)
+        : value_(std::make_shared<M>(std::move(value)))
+    {
+#ifdef DEBUG
+        std::cout << "Shared : Value constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    /** Read access
+     *  \return A reference to the shared value
+     */
+    const M& operator*() const noexcept
+    {
+        return *value_;
+    }
+    const M* operator->() const noexcept
+    {
+        return value_.get();
+    }
+
+    /** Write access
+     *  \brief Copies the value first if another handle shares it
+     *  \return A reference to the value owned by this handle only
+     */
+    M& Mutable()
+    {
+        if( value_.use_count() != 1 )
+            value_ = std::make_shared<M>(*value_);
+        return *value_;
+    }
+
+    /** Sharing test
+     *  \return True if another handle points to the same value
+     */
+    bool IsShared() const noexcept
+    {
+        return value_.use_count() != 1;
+    }
+
+    /** Swap function
+     *  \param first First object to swap
+     *  \param second Second object to swap
+     */
+    friend void swap(Shared& first, Shared& second) noexcept
+    {
+        using std::swap;
+
+        swap(first.value_, second.value_);
+    }
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_SHARED_HPP
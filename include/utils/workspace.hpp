@@ -0,0 +1,198 @@
+///
+/// \file include/utils/workspace.hpp
+/// \brief Workspace header
+/// \details Provide a bump arena of aligned scratch memory for the out-of-place operator applications.
+/// \author Philippe Ganz <philippe.ganz@gmail.com> 2017-2019
+/// \version 1.0.1
+/// \date August 2019
+/// \copyright GPL-3.0
+///
+
+#ifndef ASTROQUT_UTILS_WORKSPACE_HPP
+#define ASTROQUT_UTILS_WORKSPACE_HPP
+
+#include "const.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#ifndef __unix__
+#include <malloc.h>
+#endif // __unix__
+
+namespace alias
+{
+
+class Workspace
+{
+public:
+    static constexpr size_t alignment = 64; //!< Alignment of every buffer, one cache line
+    static constexpr size_t block_bytes_min = (size_t)1 << 20; //!< Smallest block requested from the system
+
+private:
+    /** Block of system memory, kept until the workspace is destroyed
+     */
+    struct Block
+    {
+        char* data; //!< Member variable "data"
+        size_t bytes; //!< Member variable "bytes" usable size of the block
+    };
+
+    std::vector<Block> blocks_; //!< Member variable "blocks_"
+    size_t block_index_; //!< Member variable "block_index_" block currently handing out memory
+    size_t offset_; //!< Member variable "offset_" first free byte of the current block
+    size_t allocations_; //!< Member variable "allocations_" amount of blocks requested from the system
+
+    /** Round a size up to the next multiple of the alignment
+     *  \param bytes Size to round
+     *  \return The rounded size
+     */
+    static size_t RoundUp(size_t bytes) noexcept
+    {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+public:
+    /** Default constructor
+     *  Create an empty workspace, the memory is requested on first use
+     */
+    Workspace() noexcept
+        : blocks_()
+        , block_index_(0)
+        , offset_(0)
+        , allocations_(0)
+    {
+#ifdef DEBUG
+        std::cout << "Workspace : Default constructor called" << std::endl;
+#endif // DEBUG
+    }
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    /** Default destructor
+     */
+    ~Workspace()
+    {
+#ifdef DEBUG
+        std::cout << "Workspace : Destructor called" << std::endl;
+#endif // DEBUG
+        for( Block& block : blocks_ )
+        {
+#ifdef __unix__
+            std::free(block.data);
+#else
+            _aligned_free(block.data);
+#endif // __unix__
+        }
+    }
+
+    /** Per thread instance
+     *  \return A reference to the workspace of the calling thread
+     */
+    static Workspace& Local()
+    {
+        thread_local Workspace workspace;
+        return workspace;
+    }
+
+    /** Reserve uninitialized scratch memory
+     *  \brief The memory stays reserved until the enclosing Frame is destroyed, the system is only called
+     *  when no kept block has room left
+     *  \param count Amount of elements
+     *  \return A pointer aligned on Workspace::alignment
+     */
+    template<class U>
+    U* Allocate(size_t count)
+    {
+        const size_t bytes = RoundUp(count * sizeof(U));
+        while( block_index_ < blocks_.size() )
+        {
+            if( offset_ + bytes <= blocks_[block_index_].bytes )
+            {
+                U* ptr = reinterpret_cast<U*>(blocks_[block_index_].data + offset_);
+                offset_ += bytes;
+                return ptr;
+            }
+            ++block_index_;
+            offset_ = 0;
+        }
+
+        // grow geometrically so that the amount of blocks stays logarithmic
+        size_t block_bytes = std::max(bytes, block_bytes_min);
+        if( !blocks_.empty() )
+            block_bytes = std::max(block_bytes, 2 * blocks_.back().bytes);
+#ifdef __unix__
+        char* data = static_cast<char*>(std::aligned_alloc(alignment, block_bytes));
+#else
+        char* data = static_cast<char*>(_aligned_malloc(block_bytes, alignment));
+#endif // __unix__
+        if( data == nullptr )
+            throw std::bad_alloc();
+        ++allocations_;
+
+        blocks_.push_back(Block{data, block_bytes});
+        block_index_ = blocks_.size() - 1;
+        offset_ = bytes;
+        return reinterpret_cast<U*>(data);
+    }
+
+    /** Access allocations_
+     * \return The amount of blocks requested from the system so far
+     */
+    size_t Allocations() const noexcept
+    {
+        return allocations_;
+    }
+
+    /** Total size
+     * \return The amount of bytes held by the workspace
+     */
+    size_t Bytes() const noexcept
+    {
+        size_t bytes = 0;
+        for( const Block& block : blocks_ )
+            bytes += block.bytes;
+        return bytes;
+    }
+
+    /** RAII reservation frame
+     *  \brief The memory reserved while a Frame is alive is handed back when it is destroyed, frames nest like the calls
+     */
+    class Frame
+    {
+    private:
+        Workspace& workspace_; //!< Member variable "workspace_"
+        size_t block_index_; //!< Member variable "block_index_" position to restore
+        size_t offset_; //!< Member variable "offset_" position to restore
+
+    public:
+        /** Default constructor
+         *  \param workspace Workspace to reserve memory from
+         */
+        explicit Frame(Workspace& workspace) noexcept
+            : workspace_(workspace)
+            , block_index_(workspace.block_index_)
+            , offset_(workspace.offset_)
+        {}
+
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        /** Default destructor
+         */
+        ~Frame()
+        {
+            workspace_.block_index_ = block_index_;
+            workspace_.offset_ = offset_;
+        }
+    };
+};
+
+} // namespace alias
+
+#endif // ASTROQUT_UTILS_WORKSPACE_HPP
@@ -8,12 +8,16 @@
 /// \copyright GPL-3.0
 ///
 
+#include "utils/linearop/matrix/view.hpp"
 #include "utils/linearop/operator/astrooperator.hpp"
+#include "utils/linearop/operator/hybridmatmult.hpp"
+#include "utils/linearop/operator/restrictedoperator.hpp"
 #include "WS/astroQUT.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <memory>
 #include <random>
 #include <vector>
 
@@ -25,21 +29,20 @@ namespace WS
 {
 
 
-static Matrix<double> CenterOffset(std::string picture_path, int offset_vert, int offset_horiz, Parameters<double>& options)
+template<class T>
+static Matrix<T> CenterOffset(std::string picture_path, int offset_vert, int offset_horiz, Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "CenterOffset called" << std::endl;
 #endif // DEBUG
-    Matrix<double> result(options.pic_size, options.pic_size);
-    Matrix<double> raw_picture(picture_path);
+    Matrix<T> raw_picture(picture_path, (double) 0); // headerless input files hold double precision data
     size_t raw_pic_size = (size_t) sqrt(raw_picture.Length());
     size_t offset_base = (raw_pic_size-options.pic_size)/2;
     size_t offset_height = offset_base * (1 + offset_vert/100);
     size_t offset_width = offset_base * (1 + offset_horiz/100);
-    #pragma omp parallel for simd collapse(2)
-    for(size_t row = 0; row < options.pic_size; ++row)
-        for(size_t col = 0; col < options.pic_size; ++col)
-            result[row*options.pic_size + col] = raw_picture[(row+offset_height)*raw_pic_size + (col+offset_width)];
+    Matrix<T> result = MatrixView<T>(raw_picture.Data(), raw_pic_size, raw_pic_size)
+                                .Block(offset_height, offset_width, options.pic_size, options.pic_size)
+                                .Copy();
 
 #ifdef DEBUG
     std::cerr << "CenterOffset done" << std::endl;
@@ -47,7 +50,8 @@ static Matrix<double> CenterOffset(std::string picture_path, int offset_vert, in
     return result;
 }
 
-static Matrix<double> Resample(Matrix<double> picture, size_t resample_windows_size)
+template<class T>
+static Matrix<T> Resample(Matrix<T> picture, size_t resample_windows_size)
 {
 #ifdef DEBUG
     std::cerr << "Resample called" << std::endl;
@@ -56,7 +60,7 @@ static Matrix<double> Resample(Matrix<double> picture, size_t resample_windows_s
     if(resample_windows_size == 1)
         return picture;
 
-    Matrix<double> result(picture.Height(), picture.Width());
+    Matrix<T> result(picture.Height(), picture.Width());
     std::random_device rnd;
     std::default_random_engine generator(rnd() + std::chrono::system_clock::now().time_since_epoch().count());
     std::uniform_int_distribution uniform_dist(0,(int)(resample_windows_size*resample_windows_size-1));
@@ -66,7 +70,7 @@ static Matrix<double> Resample(Matrix<double> picture, size_t resample_windows_s
         for(size_t block_col = 0; block_col < picture.Width(); block_col += resample_windows_size )
         {
             // get all values from the block
-            std::vector<double> block_values;
+            std::vector<T> block_values;
             for(size_t row = block_row; row < block_row + resample_windows_size; ++row)
                 for(size_t col = block_col; col < block_col + resample_windows_size; ++col)
                     block_values.push_back(picture[row*picture.Width()+col]);
@@ -82,15 +86,15 @@ static Matrix<double> Resample(Matrix<double> picture, size_t resample_windows_s
     return result;
 }
 
-static Matrix<double> MCCompute(const Matrix<double>& mu_hat,
-                                std::vector<std::poisson_distribution<int>>& mu_hat_dist,
-                                std::default_random_engine generator)
+template<class T>
+static void MCCompute(const Matrix<T>& mu_hat,
+                      std::vector<std::poisson_distribution<int>>& mu_hat_dist,
+                      std::default_random_engine generator,
+                      Matrix<T>& mu_hat_rnd)
 {
 #ifdef DEBUG
     std::cerr << "MCCompute called" << std::endl;
 #endif // DEBUG
-    Matrix<double> mu_hat_rnd(mu_hat.Height(), mu_hat.Width());
-
     #pragma omp simd
     for(size_t i = 0; i < mu_hat.Length(); ++i)
         mu_hat_rnd[i] = mu_hat_dist[i](generator);
@@ -101,26 +105,26 @@ static Matrix<double> MCCompute(const Matrix<double>& mu_hat,
 #ifdef DEBUG
     std::cerr << "MCCompute done" << std::endl;
 #endif // DEBUG
-    return mu_hat_rnd;
 }
 
-static void BetaZero(const Matrix<double>& picture,
-                     const AstroOperator<double>& astro,
-                     Parameters<double>& options)
+template<class T>
+static void BetaZero(const Matrix<T>& picture,
+                     const AstroOperator<T>& astro,
+                     Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "BetaZero called" << std::endl;
 #endif // DEBUG
     std::cout << "Computing beta0..." << std::endl;
-    Matrix<double> x0(0.0, options.pic_size*2, 1);
+    Matrix<T> x0(0.0, options.pic_size*2, 1);
     x0[0] = 1;
-    Matrix<double> null_model = astro.BAW(x0, false, true, true, false);
+    Matrix<T> null_model = astro.BAW(x0, false, true, true, false);
 
-    Matrix<double> non_zero_values(picture.Height(), picture.Width());
+    Matrix<T> non_zero_values(picture.Height(), picture.Width());
     size_t non_zero_values_amount = 0;
 
     for(size_t i = 0; i < picture.Length(); ++i)
-        if( ! IsEqual(picture[i], 0.0) )
+        if( ! IsEqual(picture[i], (T)0) )
             non_zero_values[non_zero_values_amount++] = picture[i];
 
     // partial sort
@@ -139,35 +143,46 @@ static void BetaZero(const Matrix<double>& picture,
 #endif // DEBUG
 }
 
-static void Standardize(const Matrix<double>& mu_hat,
+template<class T>
+static void Standardize(const Matrix<T>& mu_hat,
                         std::vector<std::poisson_distribution<int>>& mu_hat_dist,
-                        const Matrix<double>& background,
-                        const AstroOperator<double>& astro,
-                        Parameters<double>& options)
+                        const Matrix<T>& background,
+                        const AstroOperator<T>& astro,
+                        Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "Standardize called" << std::endl;
 #endif // DEBUG
     std::cout << "Computing standardization matrix..." << std::endl;
-    Matrix<double> MC_astro(options.pic_size*2, options.MC_max);
+    Matrix<T> MC_astro(options.pic_size*2, options.MC_max);
+    MemoryPool::Scope pool_scope; // the Monte-Carlo iterations all allocate the same buffers
 
     std::random_device rnd;
-    #pragma omp parallel for schedule(dynamic)
-    for(size_t MC_id = 0; MC_id < options.MC_max; ++MC_id)
+    #pragma omp parallel
     {
-        std::default_random_engine generator(rnd() + omp_get_thread_num() + std::chrono::system_clock::now().time_since_epoch().count());
-        if(options.MC_max > 100 && (MC_id % ((options.MC_max)/100) == 0))
-            std::cout << "\r" + std::to_string(std::lround(MC_id*100.0/(double)(options.MC_max-1))) + "/100" << std::flush;
+        // buffers of the thread, reused by all its simulations
+        Workspace& workspace = Workspace::Local();
+        Matrix<T> mu_hat_rnd(mu_hat.Height(), mu_hat.Width());
+        Matrix<T> rnd_result(options.pic_size*2, 1);
 
-        Matrix<double> rnd_result = astro.WtAtBt(MCCompute(mu_hat, mu_hat_dist, generator), false, true, true, false).Abs();
+        #pragma omp for schedule(dynamic)
+        for(size_t MC_id = 0; MC_id < options.MC_max; ++MC_id)
+        {
+            std::default_random_engine generator(rnd() + omp_get_thread_num() + std::chrono::system_clock::now().time_since_epoch().count());
+            if(options.MC_max > 100 && (MC_id % ((options.MC_max)/100) == 0))
+                std::cout << "\r" + std::to_string(std::lround(MC_id*100.0/(double)(options.MC_max-1))) + "/100" << std::flush;
 
-        #pragma omp simd
-        for(size_t i = 0; i < rnd_result.Height(); ++i )
-            MC_astro[i*MC_astro.Width() + MC_id] = rnd_result[i];
+            MCCompute(mu_hat, mu_hat_dist, generator, mu_hat_rnd);
+            astro.WtAtBt(mu_hat_rnd, rnd_result, workspace, false, true, true, false);
+
+            #pragma omp simd
+            for(size_t i = 0; i < rnd_result.Height(); ++i )
+                MC_astro[i*MC_astro.Width() + MC_id] = std::abs(rnd_result[i]);
+        }
     }
     std::cout << "\r100/100" << std::endl;
 
-    options.standardize = Matrix<double>(1.0, options.model_size, 1);
+    options.standardize = Matrix<T>(1.0, options.model_size, 1);
 
     #pragma omp parallel for
     for(size_t i = 0; i < options.pic_size*2; ++i)
@@ -187,7 +202,7 @@ static void Standardize(const Matrix<double>& mu_hat,
         options.standardize[i] = wavelet_max_value;
     #pragma omp parallel for simd
     for(size_t i = options.pic_size/2; i < options.pic_size; ++i)
-        options.standardize[i] = std::numeric_limits<double>::infinity();
+        options.standardize[i] = std::numeric_limits<T>::infinity();
 
     // spline ok
 
@@ -195,13 +210,13 @@ static void Standardize(const Matrix<double>& mu_hat,
     #pragma omp parallel for simd collapse(2)
     for(size_t i = 3*options.pic_size/8; i < 5*options.pic_size/8; ++i)
         for(size_t j = 3*options.pic_size/8; j < 5*options.pic_size/8; ++j)
-            options.standardize[options.pic_size*2 + i*options.pic_size + j] = std::numeric_limits<double>::infinity();
+            options.standardize[options.pic_size*2 + i*options.pic_size + j] = std::numeric_limits<T>::infinity();
     // remove point sources from empty background
     #pragma omp parallel for simd
     for(size_t i = 0; i < background.Length(); ++i)
-        if( IsEqual(background[i], 0.0) )
+        if( IsEqual(background[i], (T)0) )
         {
-            options.standardize[options.pic_size*2 + i] = std::numeric_limits<double>::infinity();
+            options.standardize[options.pic_size*2 + i] = std::numeric_limits<T>::infinity();
 #ifdef VERBOSE
             std::cout << i << " put to zero." << std::endl;
 #endif // VERBOSE
@@ -211,39 +226,50 @@ static void Standardize(const Matrix<double>& mu_hat,
 #endif // DEBUG
 }
 
-static void Lambda(const Matrix<double>& mu_hat,
+template<class T>
+static void Lambda(const Matrix<T>& mu_hat,
                    std::vector<std::poisson_distribution<int>>& mu_hat_dist,
-                   AstroOperator<double>& astro,
-                   Parameters<double>& options)
+                   AstroOperator<T>& astro,
+                   Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "Lambda called" << std::endl;
 #endif // DEBUG
     std::cout << "Computing lambda and lambdaI..." << std::endl;
-    Matrix<double> lambda_standardize(options.standardize);
-    lambda_standardize[0] = std::numeric_limits<double>::infinity();
+    Matrix<T> lambda_standardize(options.standardize);
+    lambda_standardize[0] = std::numeric_limits<T>::infinity();
     astro.Standardize(lambda_standardize);
 
-    Matrix<double> WS_max_values(-std::numeric_limits<double>::infinity(), options.MC_max, 1);
-    Matrix<double> PS_max_values(-std::numeric_limits<double>::infinity(), options.MC_max, 1);
+    Matrix<T> WS_max_values(-std::numeric_limits<T>::infinity(), options.MC_max, 1);
+    Matrix<T> PS_max_values(-std::numeric_limits<T>::infinity(), options.MC_max, 1);
 
     std::random_device rnd;
-    #pragma omp parallel for schedule(dynamic)
-    for(size_t MC_id = 0; MC_id < options.MC_max; ++MC_id)
+    #pragma omp parallel
     {
+        // buffers of the thread, reused by all its simulations
+        Workspace& workspace = Workspace::Local();
+        Matrix<T> mu_hat_rnd(mu_hat.Height(), mu_hat.Width());
+        Matrix<T> rnd_result(options.model_size, 1);
 
-        std::default_random_engine generator(rnd() + omp_get_thread_num() + std::chrono::system_clock::now().time_since_epoch().count());
+        #pragma omp for schedule(dynamic)
+        for(size_t MC_id = 0; MC_id < options.MC_max; ++MC_id)
+        {
+
+            std::default_random_engine generator(rnd() + omp_get_thread_num() + std::chrono::system_clock::now().time_since_epoch().count());
 
-        if(options.MC_max > 100 && (MC_id % ((options.MC_max)/100) == 0))
-            std::cout << "\r" + std::to_string(std::lround(MC_id*100.0/(double)(options.MC_max-1))) + "/100" << std::flush;
+            if(options.MC_max > 100 && (MC_id % ((options.MC_max)/100) == 0))
+                std::cout << "\r" + std::to_string(std::lround(MC_id*100.0/(double)(options.MC_max-1))) + "/100" << std::flush;
 
-        Matrix<double> rnd_result = astro.WtAtBt(MCCompute(mu_hat, mu_hat_dist, generator)).Abs();
+            MCCompute(mu_hat, mu_hat_dist, generator, mu_hat_rnd);
+            astro.WtAtBt(mu_hat_rnd, rnd_result, workspace);
+            std::move(rnd_result).Abs();
 
-        // compute max value for each MC simulation in wavelet and spline results
-        WS_max_values[MC_id] = *std::max_element(&rnd_result[0], &rnd_result[options.pic_size*2]);
+            // compute max value for each MC simulation in wavelet and spline results
+            WS_max_values[MC_id] = *std::max_element(&rnd_result[0], &rnd_result[options.pic_size*2]);
 
-        // compute max value for each MC simulation in point source results
-        PS_max_values[MC_id] = *std::max_element(&rnd_result[options.pic_size*2], &rnd_result[options.model_size]);
+            // compute max value for each MC simulation in point source results
+            PS_max_values[MC_id] = *std::max_element(&rnd_result[options.pic_size*2], &rnd_result[options.model_size]);
+        }
     }
     std::cout << "\r100/100" << std::endl;
 
@@ -270,19 +296,20 @@ static void Lambda(const Matrix<double>& mu_hat,
 #endif // DEBUG
 }
 
-static void StandardizeAndRegularize(const Matrix<double>& background,
-                                     AstroOperator<double>& astro,
-                                     Parameters<double>& options)
+template<class T>
+static void StandardizeAndRegularize(const Matrix<T>& background,
+                                     AstroOperator<T>& astro,
+                                     Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "StandardizeAndRegularize called" << std::endl;
 #endif // DEBUG
     std::cout << "Computing standardization and regularization values with ";
     std::cout << options.MC_max << " MC simulations..." << std::endl;
-    Matrix<double> initial_guess(0.0, options.pic_size*2, 1);
+    Matrix<T> initial_guess(0.0, options.pic_size*2, 1);
     initial_guess[0] = 1.0;
-    Matrix<double> u = astro.BAW(initial_guess, false, true, true, false);
-    Matrix<double> mu_hat = background + u*options.beta0;
+    Matrix<T> u = astro.BAW(initial_guess, false, true, true, false);
+    Matrix<T> mu_hat = background + u*options.beta0;
     std::vector<std::poisson_distribution<int>> mu_hat_dist(mu_hat.Length());
     #pragma omp parallel for simd
     for(size_t i = 0; i < mu_hat.Length(); ++i)
@@ -302,29 +329,26 @@ static void StandardizeAndRegularize(const Matrix<double>& background,
 #endif // DEBUG
 }
 
-static Matrix<double> Estimate(const Matrix<double>& picture,
-                               const Matrix<double>& background,
-                               const AstroOperator<double>& astro,
-                               Parameters<double>& options)
+template<class T>
+static Matrix<T> Estimate(const Matrix<T>& picture,
+                          const Matrix<T>& background,
+                          const AstroOperator<T>& astro,
+                          Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "Estimate called" << std::endl;
 #endif // DEBUG
     std::cout << "Computing static estimate..." << std::endl;
-    options.fista_params.init_value = Matrix<double>(0.0, options.model_size, 1);
+    options.fista_params.init_value = Matrix<T>(0.0, options.model_size, 1);
     options.fista_params.init_value[0] = options.beta0 * options.standardize[0];
-    options.fista_params.indices = Matrix<size_t>(0,1+options.pic_size+options.pic_size*options.pic_size,1);
-    #pragma omp parallel for simd
-    for(size_t i = 1; i < 1+options.pic_size+options.pic_size*options.pic_size; ++i)
-        options.fista_params.indices[i] = i + options.pic_size - 1;
+    // intercept, spline and point sources are non-negative
+    options.fista_params.non_negative = {{0, 1}, {options.pic_size, options.model_size}};
 
-    Matrix<double> result = fista::poisson::Solve(astro, background, picture, options.lambda, options.fista_params);
+    Matrix<T> result = fista::poisson::Solve(astro, background, picture, options.lambda, options.fista_params);
 
     result /= options.standardize;
     result.RemoveNeg(options.pic_size*2, options.model_size);
-    Matrix<double> result_ps(&result[options.pic_size*2], options.pic_size, options.pic_size);
-    Matrix<double> ps_cc_max = result_ps.ConnectedComponentsMax();
-    result_ps.Data(nullptr);
+    Matrix<T> ps_cc_max = MatrixView<T>(&result[options.pic_size*2], options.pic_size, options.pic_size).Borrow().ConnectedComponentsMax();
     #pragma omp parallel for simd
     for(size_t i = 0; i < options.pic_size*options.pic_size; ++i)
         result[i + options.pic_size*2] = ps_cc_max[i];
@@ -336,36 +360,64 @@ static Matrix<double> Estimate(const Matrix<double>& picture,
     return result;
 }
 
-static Matrix<double> EstimateNonZero(const Matrix<double>& picture,
-                                      const Matrix<double>& background,
-                                      const Matrix<double>& solution_static,
-                                      const AstroOperator<double>& astro,
-                                      Parameters<double>& options)
+template<class T>
+static HybridMatMult<T> ExplicitRefitOperator(const Matrix<T>& picture,
+                                              const Matrix<size_t>& non_zero_elements_indices,
+                                              const AstroOperator<T>& astro,
+                                              const Parameters<T>& options)
 {
 #ifdef DEBUG
-    std::cerr << "EstimateNonZero called" << std::endl;
+    std::cerr << "ExplicitRefitOperator called" << std::endl;
 #endif // DEBUG
-    std::cout << "Getting non zero elements..." << std::endl;
-    Matrix<size_t> non_zero_elements_indices = solution_static.NonZeroIndices();
     size_t non_zero_elements_amount = non_zero_elements_indices.Length();
-    MatMult<double> non_zero_elements_operator(Matrix<double>(picture.Length(), non_zero_elements_amount), picture.Length(), non_zero_elements_amount);
+    // wavelet and spline columns cover the whole picture, point source columns only the blurring filter support
+    size_t dense_elements_amount = 0;
+    while(dense_elements_amount < non_zero_elements_amount && non_zero_elements_indices[dense_elements_amount] < options.pic_size*2)
+        ++dense_elements_amount;
 
     std::cout << "Generating non zero elements operator..." << std::endl;
-    Matrix<double> identity(0.0, options.model_size, 1);
-    for(size_t i = 0; i < non_zero_elements_amount; ++i)
-    {
-        if(non_zero_elements_amount > 100 && i % ((non_zero_elements_amount)/100) == 0)
-            std::cout << "\r" + std::to_string(std::lround(i*100.0/(double)(non_zero_elements_amount-1))) + "/100" << std::flush;
-        identity[non_zero_elements_indices[i]] = 1.0;
-        Matrix<double> local_result = astro * identity;
-        identity[non_zero_elements_indices[i]] = 0.0;
-        #pragma omp parallel for simd
-        for(size_t j = 0; j < local_result.Length(); ++j)
-            non_zero_elements_operator[j*non_zero_elements_amount + i] = local_result[j];
-    }
+    Matrix<T> identity(0.0, options.model_size, 1);
+    HybridMatMult<T> non_zero_elements_operator(picture.Length(), non_zero_elements_amount, dense_elements_amount,
+        [&](size_t i)
+        {
+            if(non_zero_elements_amount > 100 && i % ((non_zero_elements_amount)/100) == 0)
+                std::cout << "\r" + std::to_string(std::lround(i*100.0/(double)(non_zero_elements_amount-1))) + "/100" << std::flush;
+            identity[non_zero_elements_indices[i]] = 1.0;
+            Matrix<T> local_result = astro * identity;
+            identity[non_zero_elements_indices[i]] = 0.0;
+            return local_result;
+        });
     std::cout << "\r100/100" << std::endl;
+    std::cout << "Operator storage: " << non_zero_elements_operator.Bytes() << " bytes instead of "
+              << picture.Length() * non_zero_elements_amount * sizeof(T) << " bytes dense" << std::endl;
 
-    options.fista_params.init_value = Matrix<double>(non_zero_elements_amount, 1);
+#ifdef DEBUG
+    std::cerr << "ExplicitRefitOperator done" << std::endl;
+#endif // DEBUG
+    return non_zero_elements_operator;
+}
+
+template<class T>
+static Matrix<T> EstimateNonZero(const Matrix<T>& picture,
+                                 const Matrix<T>& background,
+                                 const Matrix<T>& solution_static,
+                                 const AstroOperator<T>& astro,
+                                 Parameters<T>& options)
+{
+#ifdef DEBUG
+    std::cerr << "EstimateNonZero called" << std::endl;
+#endif // DEBUG
+    std::cout << "Getting non zero elements..." << std::endl;
+    Matrix<size_t> non_zero_elements_indices = solution_static.NonZeroIndices();
+    size_t non_zero_elements_amount = non_zero_elements_indices.Length();
+    // the weighted Gram matrix of the second order solver needs every column at each iteration, they are computed once
+    std::unique_ptr<Operator<T>> non_zero_elements_operator;
+    if( options.refit_operator == explicit_columns || options.refit_solver == second_order )
+        non_zero_elements_operator.reset(new HybridMatMult<T>(ExplicitRefitOperator(picture, non_zero_elements_indices, astro, options)));
+    else
+        non_zero_elements_operator.reset(new RestrictedOperator<T>(astro, non_zero_elements_indices));
+
+    options.fista_params.init_value = Matrix<T>(non_zero_elements_amount, 1);
 
     #pragma omp parallel for simd
     for(size_t i = 0; i < non_zero_elements_amount; ++i)
@@ -374,20 +426,23 @@ static Matrix<double> EstimateNonZero(const Matrix<double>& picture,
     size_t starting_index = 1;
     while(non_zero_elements_indices[starting_index] < options.pic_size)
         ++starting_index;
-    Matrix<size_t> remove_neg_indices(non_zero_elements_amount-starting_index, 1);
-    #pragma omp parallel for simd
-    for(size_t i = 0; i < non_zero_elements_amount-starting_index; ++i)
-        remove_neg_indices[i] = i + starting_index;
-    options.fista_params.indices = remove_neg_indices;
+    options.fista_params.non_negative = {{starting_index, non_zero_elements_amount}};
 
     std::cout << "Generating the new beta estimates..." << std::endl;
-    Matrix<double> beta_new = fista::poisson::Solve(non_zero_elements_operator,
-                                                    background,
-                                                    picture,
-                                                    0.0,
-                                                    options.fista_params);
-
-    Matrix<double> result(solution_static);
+    Matrix<T> beta_new;
+    if( options.refit_solver == second_order )
+        beta_new = newton::poisson::Solve(*non_zero_elements_operator,
+                                          background,
+                                          picture,
+                                          options.fista_params);
+    else
+        beta_new = fista::poisson::Solve(*non_zero_elements_operator,
+                                         background,
+                                         picture,
+                                         (T)0,
+                                         options.fista_params);
+
+    Matrix<T> result(solution_static);
     #pragma omp parallel for simd
     for(size_t i = 0; i < non_zero_elements_amount; ++i)
         result[non_zero_elements_indices[i]] = beta_new[i];
@@ -397,22 +452,28 @@ static Matrix<double> EstimateNonZero(const Matrix<double>& picture,
     return result;
 }
 
-static Matrix<double> SolveWS(const Matrix<double>& picture,
-                              const Matrix<double>& sensitivity,
-                              const Matrix<double>& background,
-                              Parameters<double>& options)
+template<class T>
+static Matrix<T> SolveWS(const Matrix<T>& picture,
+                         const Matrix<T>& sensitivity,
+                         const Matrix<T>& background,
+                         Parameters<T>& options)
 {
 #ifdef DEBUG
     std::cerr << "SolveWS called" << std::endl;
 #endif // DEBUG
-    AstroOperator<double> astro(options.pic_size, options.pic_size, options.pic_size/2, sensitivity, Matrix<double>(1, options.model_size, 1), false, options);
+    AstroOperator<T> astro(options.pic_size, options.pic_size, options.pic_size/2, sensitivity, Matrix<T>(1, options.model_size, 1), false, options);
+    if( options.blurring_backend == blurring_separable )
+    {
+        std::cout << "Separable blurring filter of rank " << astro.Blur().Separable().Rank();
+        std::cout << ", relative error " << std::scientific << astro.Blur().Separable().Error() << std::defaultfloat << std::endl << std::endl;
+    }
 
     BetaZero(picture, astro, options);
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
-    Matrix<double> solution;
+    Matrix<T> solution;
     bool first = true;
-    double prev_beta0 = std::numeric_limits<double>::infinity();
+    T prev_beta0 = std::numeric_limits<T>::infinity();
     size_t refine_max = 5;
     double total_time = 0;
     size_t iter_max = options.fista_params.iter_max;
@@ -438,7 +499,7 @@ static Matrix<double> SolveWS(const Matrix<double>& picture,
             Matrix<size_t> zero_elements = solution.ZeroIndices();
             #pragma omp parallel for simd
             for(size_t i = 0; i < zero_elements.Length(); ++i)
-                options.standardize[zero_elements[i]] = std::numeric_limits<double>::infinity();
+                options.standardize[zero_elements[i]] = std::numeric_limits<T>::infinity();
             astro.Standardize(options.standardize);
             options.fista_params.iter_max = iter_max;
         }
@@ -450,7 +511,7 @@ static Matrix<double> SolveWS(const Matrix<double>& picture,
         }
 
         start = std::chrono::high_resolution_clock::now();
-        Matrix<double> solution_static = Estimate(picture, background, astro, options);
+        Matrix<T> solution_static = Estimate(picture, background, astro, options);
         end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed_time_FISTA = end-start;
 
@@ -484,11 +545,12 @@ static Matrix<double> SolveWS(const Matrix<double>& picture,
     return solution/options.standardize;
 }
 
-Matrix<double> Solve(std::string picture_path,
-                     std::string sensitivity_path,
-                     std::string background_path,
-                     std::string solution_path,
-                     Parameters<double>& options )
+template<class T>
+Matrix<T> Solve(std::string picture_path,
+                std::string sensitivity_path,
+                std::string background_path,
+                std::string solution_path,
+                Parameters<T>& options )
 {
 #ifdef DEBUG
     std::cerr << "Solve called" << std::endl;
@@ -510,13 +572,13 @@ Matrix<double> Solve(std::string picture_path,
     options.MC_quantile_PS = (size_t) (options.MC_max * (1.0 - 1.0/(options.pic_size*options.pic_size)));
 
     // result matrix containing a solution on each row
-    Matrix<double> result_fhat(options.bootstrap_max, options.pic_size);
-    Matrix<double> result_fhat_cropped(options.bootstrap_max, std::lround((options.pic_size/2)*(1+1/std::sqrt(2)))-std::lround((options.pic_size/2)*(1-1/std::sqrt(2)))+2);
+    Matrix<T> result_fhat(options.bootstrap_max, options.pic_size);
+    Matrix<T> result_fhat_cropped(options.bootstrap_max, std::lround((options.pic_size/2)*(1+1/std::sqrt(2)))-std::lround((options.pic_size/2)*(1-1/std::sqrt(2)))+2);
 
     // first solution is not bootstrapped
-    Matrix<double> picture = CenterOffset(picture_path, 0, 0, options);
-    Matrix<double> sensitivity = CenterOffset(sensitivity_path, 0, 0, options);
-    Matrix<double> background = CenterOffset(background_path, 0, 0, options);
+    Matrix<T> picture = CenterOffset(picture_path, 0, 0, options);
+    Matrix<T> sensitivity = CenterOffset(sensitivity_path, 0, 0, options);
+    Matrix<T> background = CenterOffset(background_path, 0, 0, options);
     background += 1e-4 - background.Min();
 
     std::random_device rnd;
@@ -589,19 +651,21 @@ Matrix<double> Solve(std::string picture_path,
             std::cout << std::string(80, '-') << std::endl << std::endl;
         }
 
-        Matrix<double> solution = SolveWS(picture, sensitivity, background, options);
-        Matrix<double> fhatw = Matrix<double>(solution.Data(), options.pic_size, options.pic_size, 1);
-        Wavelet<double> wave_op = Wavelet<double>((WaveletType)options.wavelet[0], options.wavelet[1]);
+        Matrix<T> solution = SolveWS(picture, sensitivity, background, options);
+        Matrix<T> fhatw = Matrix<T>(solution.Data(), options.pic_size, options.pic_size, 1);
+        Wavelet<T> wave_op = Wavelet<T>((WaveletType)options.wavelet[0], options.wavelet[1]);
         fhatw = wave_op*fhatw;
 
-        Matrix<double> fhats = Matrix<double>(solution.Data()+options.pic_size, options.pic_size, options.pic_size, 1);
-        Spline<double> spline_op(options.pic_size);
+        Matrix<T> fhats = Matrix<T>(solution.Data()+options.pic_size, options.pic_size, options.pic_size, 1);
+        Spline<T> spline_op(options.pic_size);
         fhats = spline_op*fhats;
 
-        Matrix<double> fhat = fhatw + fhats;
+        Matrix<T> fhat = fhatw + fhats;
         std::copy(fhat.Data(), fhat.Data()+fhat.Length(), result_fhat.Data()+bootstrap_current*fhat.Length());
 
-        Matrix<double> fhat_cropped = fhat.Partial(std::lround((options.pic_size/2)*(1-1/std::sqrt(2)))-1, std::lround((options.pic_size/2)*(1+1/std::sqrt(2))));
+        size_t crop_start = std::lround((options.pic_size/2)*(1-1/std::sqrt(2)))-1;
+        size_t crop_end = std::lround((options.pic_size/2)*(1+1/std::sqrt(2)));
+        MatrixView<T> fhat_cropped = MatrixView<T>(fhat).Segment(crop_start, crop_end-crop_start+1);
         std::copy(fhat_cropped.Data(), fhat_cropped.Data()+fhat_cropped.Length(), result_fhat_cropped.Data()+bootstrap_current*fhat_cropped.Length());
 
         // write current results to disc
@@ -615,5 +679,8 @@ Matrix<double> Solve(std::string picture_path,
     return result_fhat_cropped;
 }
 
+template Matrix<float> Solve(std::string, std::string, std::string, std::string, Parameters<float>&);
+template Matrix<double> Solve(std::string, std::string, std::string, std::string, Parameters<double>&);
+
 } // namespace WS
 } // namespace alias
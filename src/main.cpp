@@ -18,19 +18,42 @@
 
 void usage()
 {
-    std::cerr << std::endl << "usage : ASTROQUT -f|--source SOURCE -e|--sensitivity SENSITIVITY -o|--background BACKGROUND -b|--blurring BLURRING -r|--result RESULT -s|--size SIZE -x|--bootstrap BOOTSTRAP" << std::endl << std::endl;
+    std::cerr << std::endl << "usage : ASTROQUT -f|--source SOURCE -e|--sensitivity SENSITIVITY -o|--background BACKGROUND -b|--blurring BLURRING -r|--result RESULT -s|--size SIZE -x|--bootstrap BOOTSTRAP [-p|--precision PRECISION] [-c|--convolution CONVOLUTION] [-t|--tolerance TOLERANCE]" << std::endl << std::endl;
     std::cerr << "  SOURCE - Path to the source image;" << std::endl;
     std::cerr << "  SENSITIVITY - Path to the sensitivity image;" << std::endl;
     std::cerr << "  BACKGROUND - Path to the background image;" << std::endl;
     std::cerr << "  BLURRING - Path to the blurring filter, defaults to data/blurring.data;" << std::endl;
     std::cerr << "  RESULT - Path to the solution file;" << std::endl;
     std::cerr << "  SIZE - Width of the picture;" << std::endl;
-    std::cerr << "  BOOTSTRAP - Amount of bootstraps to perform." << std::endl << std::endl;
+    std::cerr << "  BOOTSTRAP - Amount of bootstraps to perform;" << std::endl;
+    std::cerr << "  PRECISION - Floating point precision of the solver, float or double, defaults to double;" << std::endl;
+    std::cerr << "  CONVOLUTION - Backend of the blurring, direct, fourier, separable or auto to measure the fastest exact one, defaults to auto;" << std::endl;
+    std::cerr << "  TOLERANCE - Relative error allowed on the blurring filter by the separable backend, defaults to 1e-3." << std::endl << std::endl;
+}
+
+template<class T>
+void Run(const std::string& source,
+         const std::string& sensitivity,
+         const std::string& background,
+         const std::string& blurring,
+         const std::string& result,
+         size_t pic_size,
+         size_t bootstrap_max,
+         alias::BlurringBackend blurring_backend,
+         double blurring_tolerance)
+{
+    alias::WS::Parameters<T> options;
+    options.blurring_filter = blurring;
+    options.blurring_backend = blurring_backend;
+    options.blurring_tolerance = blurring_tolerance;
+    options.pic_size = pic_size;
+    options.bootstrap_max = bootstrap_max;
+
+    alias::WS::Solve(source, sensitivity, background, result, options);
 }
 
 int main( int argc, char **argv )
 {
-    alias::WS::Parameters<double> options;
     std::string source;
     std::string sensitivity;
     std::string background;
@@ -38,6 +61,9 @@ int main( int argc, char **argv )
     std::string result;
     size_t pic_size = 0;
     size_t bootstrap_max = 0;
+    std::string precision("double");
+    std::string convolution("auto");
+    double tolerance = 1e-3;
 
     int c;
 
@@ -52,12 +78,15 @@ int main( int argc, char **argv )
             {"result",      required_argument, nullptr, 'r'},
             {"size",        required_argument, nullptr, 's'},
             {"bootstrap",   required_argument, nullptr, 'x'},
+            {"precision",   required_argument, nullptr, 'p'},
+            {"convolution", required_argument, nullptr, 'c'},
+            {"tolerance",   required_argument, nullptr, 't'},
             {nullptr,       0,                 nullptr, 0}
         };
         /* getopt_long stores the option index here. */
         int option_index = 0;
 
-        c = getopt_long (argc, argv, "f:e:o:b:r:s:x:", long_options, &option_index);
+        c = getopt_long (argc, argv, "f:e:o:b:r:s:x:p:c:t:", long_options, &option_index);
 
         /* Detect the end of the options. */
         if (c == -1)
@@ -107,6 +136,24 @@ int main( int argc, char **argv )
             break;
         }
 
+        case 'p':
+        {
+            precision = std::string(optarg);
+            break;
+        }
+
+        case 'c':
+        {
+            convolution = std::string(optarg);
+            break;
+        }
+
+        case 't':
+        {
+            tolerance = strtod(optarg, nullptr);
+            break;
+        }
+
         default:
         {
             usage();
@@ -121,17 +168,27 @@ int main( int argc, char **argv )
         blurring.compare("") == 0 ||
         result.compare("") == 0 ||
         pic_size == 0 ||
-        bootstrap_max == 0)
+        bootstrap_max == 0 ||
+        (precision.compare("float") != 0 && precision.compare("double") != 0) ||
+        (convolution.compare("auto") != 0 && convolution.compare("direct") != 0 && convolution.compare("fourier") != 0 && convolution.compare("separable") != 0) ||
+        tolerance < 0)
     {
         usage();
         return EXIT_FAILURE;
     }
 
-    options.blurring_filter = blurring;
-    options.pic_size = pic_size;
-    options.bootstrap_max = bootstrap_max;
-
-    alias::WS::Solve(source, sensitivity, background, result, options);
+    alias::BlurringBackend blurring_backend = alias::blurring_auto;
+    if( convolution.compare("direct") == 0 )
+        blurring_backend = alias::blurring_convolution;
+    else if( convolution.compare("fourier") == 0 )
+        blurring_backend = alias::blurring_fourier;
+    else if( convolution.compare("separable") == 0 )
+        blurring_backend = alias::blurring_separable;
+
+    if( precision.compare("float") == 0 )
+        Run<float>(source, sensitivity, background, blurring, result, pic_size, bootstrap_max, blurring_backend, tolerance);
+    else
+        Run<double>(source, sensitivity, background, blurring, result, pic_size, bootstrap_max, blurring_backend, tolerance);
 
     return EXIT_SUCCESS;
 }
@@ -19,6 +19,7 @@ bool OperatorTest()
     using namespace oper;
 
     bool convolution = ConvolutionTest();
+    bool convolution_interior = ConvolutionTestInterior();
 
 //    ConvolutionTime(1024, 5);
 
@@ -27,8 +28,11 @@ bool OperatorTest()
     bool abel_apply2 = AbelTestApply2();
     bool abel_transposed = AbelTestTransposed();
     bool abel_transposed2 = AbelTestTransposed2();
+    bool abel_multiple = AbelTestMultiple();
+    bool abel_storage = AbelTestStorage();
 
 //    AbelTime(512);
+//    AbelTime(512, abel_on_the_fly);
 
     bool wavelet = WaveletTest();
     bool wavelet2 = WaveletTest2();
@@ -37,20 +41,37 @@ bool OperatorTest()
     bool spline = SplineTest();
 
     bool blur = BlurTest();
+    bool blur_backend = BlurBackendTest();
+    bool separable = SeparableConvolutionTest();
+
+    bool hybrid = HybridTest();
+
+    bool fourier_dft = FourierTestDFT();
+    bool fourier_real = FourierTestReal();
 
     bool astro = AstroTest();
     bool astro_transposed = AstroTestTransposed();
 
-    return convolution && abel_build && abel_apply && abel_apply2 && abel_transposed && abel_transposed2 && wavelet && wavelet2 && wavelet3 && spline && blur && astro && astro_transposed;
+    bool restricted = RestrictedTest();
+
+    bool apply = ApplyTest();
+    bool shared_state = SharedStateTest();
+    bool transpose_flag = TransposeFlagTest();
+    bool abel_spline = AbelSplineTest();
+
+    return convolution && convolution_interior && abel_build && abel_apply && abel_apply2 && abel_transposed && abel_transposed2 && abel_multiple && abel_storage && wavelet && wavelet2 && wavelet3 && spline && blur && blur_backend && separable && hybrid && fourier_dft && fourier_real && astro && astro_transposed && restricted && apply && shared_state && transpose_flag && abel_spline;
 }
 
 bool FISTATest()
 {
     bool fista_small = fista::SmallExample();
+    bool fista_proximal = fista::Proximal();
+    bool fista_single_precision = fista::SinglePrecision();
+    bool newton = fista::Newton();
 
 //    fista::Time(1024);
 
-    return fista_small;
+    return fista_small && fista_proximal && fista_single_precision && newton;
 }
 
 } // namespace test
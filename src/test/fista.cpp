@@ -62,6 +62,168 @@ bool SmallExample()
     return fista_test;
 }
 
+bool Proximal()
+{
+    std::cout << "FISTA proximal gradient step test : ";
+
+    double y_data[8] = {1.0, -1.0, 2.0, -2.0, 0.5, -0.5, 3.0, -3.0};
+    const Matrix<double> y(y_data, 8, 8, 1);
+    double grad_data[8] = {4.0, 0.0, 2.0, -2.0, 0.0, 0.0, -2.0, 2.0};
+    const Matrix<double> grad(grad_data, 8, 8, 1);
+    Matrix<double> x(8, 1);
+
+    // step y - grad/2 = {-1, -1, 1, -1, 0.5, -0.5, 4, -4}, shrinkage of 0.5 from the second element,
+    // non-negative first element and elements 3 to 6
+    alias::fista::poisson::ProximalGradient(y, grad, 1.0, 2.0, {{0, 1}, {3, 6}}, x);
+
+    double expected_data[8] = {0.0, -0.5, 0.5, 0.0, 0.0, 0.0, 3.5, -3.5};
+    const Matrix<double> expected_result(expected_data, 8, 8, 1);
+    bool test_result = Compare(expected_result, x);
+
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+/** Relative norm difference of a single precision result to its double precision counterpart
+ */
+static double RelativeError(const Matrix<float>& actual, const Matrix<double>& expected)
+{
+    double difference = 0.0;
+    #pragma omp parallel for reduction(+:difference)
+    for(size_t i = 0; i < expected.Length(); ++i)
+        difference += ((double) actual[i] - expected[i]) * ((double) actual[i] - expected[i]);
+    return std::sqrt(difference) / expected.Norm(two);
+}
+
+bool SinglePrecision()
+{
+    std::cout << "FISTA test of the single precision pipeline against double precision : " << std::endl << std::endl;
+
+    size_t pic_size = 64;
+    size_t model_size = (pic_size + 2) * pic_size;
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.1, 1.0);
+
+    Matrix<double> sensitivity(pic_size*pic_size, 1);
+    Matrix<double> standardize(model_size, 1);
+    Matrix<double> x(model_size, 1);
+    Matrix<double> u(pic_size*pic_size, 1);
+    Matrix<double> b(pic_size*pic_size, 1);
+    for(size_t i = 0; i < pic_size*pic_size; ++i)
+        sensitivity[i] = distribution(generator);
+    for(size_t i = 0; i < model_size; ++i)
+        standardize[i] = 0.5 + distribution(generator);
+    for(size_t i = 0; i < model_size; ++i)
+        x[i] = distribution(generator) - 0.3;
+    for(size_t i = 0; i < pic_size*pic_size; ++i)
+        u[i] = 0.5 + distribution(generator);
+    for(size_t i = 0; i < pic_size*pic_size; ++i)
+        b[i] = std::floor(10*distribution(generator));
+
+    WS::Parameters<double> params_double;
+    WS::Parameters<float> params_float;
+    AstroOperator<double> astro_double(pic_size, pic_size, pic_size/2, sensitivity, standardize, false, params_double);
+    AstroOperator<float> astro_float(pic_size, pic_size, pic_size/2, Matrix<float>(sensitivity), Matrix<float>(standardize), false, params_float);
+
+    double forward_error = RelativeError(astro_float * Matrix<float>(x), astro_double * x);
+    std::cout << "Forward operator relative norm error: " << forward_error << std::endl;
+
+    AstroOperator<float>* astro_float_transposed = astro_float.Clone();
+    AstroOperator<double>* astro_double_transposed = astro_double.Clone();
+    double transposed_error = RelativeError(astro_float_transposed->Transpose() * Matrix<float>(b), astro_double_transposed->Transpose() * b);
+    delete astro_float_transposed;
+    delete astro_double_transposed;
+    std::cout << "Transposed operator relative norm error: " << transposed_error << std::endl;
+
+    alias::fista::poisson::Parameters<double> options_double;
+    options_double.iter_max = 50;
+    options_double.log = false;
+    options_double.non_negative = {{2*pic_size, model_size}};
+    alias::fista::poisson::Parameters<float> options_float;
+    options_float.iter_max = options_double.iter_max;
+    options_float.log = false;
+    options_float.non_negative = options_double.non_negative;
+
+    Matrix<double> solution_double = alias::fista::poisson::Solve(astro_double, u, b, 0.1, options_double);
+    Matrix<float> solution_float = alias::fista::poisson::Solve(astro_float, Matrix<float>(u), Matrix<float>(b), 0.1f, options_float);
+    double solution_error = RelativeError(solution_float, solution_double);
+    std::cout << "FISTA solution relative norm error: " << solution_error << std::endl;
+
+    bool operator_test = forward_error < 1e-5 && transposed_error < 1e-5;
+    bool solution_test = solution_error < 1e-3;
+
+    std::cout << std::endl << (operator_test && solution_test ? "Success" : "Failure") << ", achieved ";
+    std::cout << std::max(forward_error, transposed_error) << " relative norm error on the operator and ";
+    std::cout << solution_error << " on the solution." << std::endl << std::endl;
+
+    return operator_test && solution_test;
+}
+
+bool Newton()
+{
+    std::cout << "Newton refit test : " << std::endl << std::endl;
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    size_t test_height = 300;
+    size_t test_width = 12;
+    size_t dense_width = 4;
+
+    // positive dense leading columns, then columns with a small support as the point sources
+    Matrix<double> A_data(0.0, test_height, test_width);
+    for(size_t col = 0; col < test_width; ++col)
+        for(size_t row = 0; row < test_height; ++row)
+            if( col < dense_width || (row + 3*col) % 7 == 0 )
+                A_data[row*test_width + col] = std::floor(10*distribution(generator)) + 1.0;
+    MatMult<double> A(A_data, test_height, test_width);
+    HybridMatMult<double> A_hybrid(test_height, test_width, dense_width,
+                                   [&](size_t col){ return MatrixView<double>(A_data).Block(0, col, test_height, 1).Copy(); });
+
+    Matrix<double> weights(test_height, 1);
+    for(size_t i = 0; i < test_height; ++i)
+        weights[i] = std::floor(4*distribution(generator));
+    bool gram_test = Compare(A.WeightedGram(weights), A_hybrid.WeightedGram(weights));
+
+    Matrix<double> u(test_height, 1);
+    for(size_t i = 0; i < test_height; ++i)
+        u[i] = 1.0 + distribution(generator);
+    alias::fista::poisson::Parameters<double> options;
+    options.non_negative = {{dense_width, test_width}};
+    options.tol = 1e-12;
+
+    // noise free data is fitted exactly
+    Matrix<double> x_true(test_width, 1);
+    for(size_t i = 0; i < test_width; ++i)
+        x_true[i] = 0.5 + distribution(generator);
+    Matrix<double> b = A*x_true+u;
+    Matrix<double> x = alias::newton::poisson::Solve(A_hybrid, u, b, options);
+    double recovery_error = (x - x_true).Norm(two) / x_true.Norm(two);
+    bool recovery_test = recovery_error < 1e-6;
+
+    // a negative constrained element ends on its bound, the optimality conditions hold
+    x_true[dense_width + 1] = -0.5;
+    b = A*x_true+u;
+    x = alias::newton::poisson::Solve(A_hybrid, u, b, options);
+    Matrix<double> Axu = A*x+u;
+    MatMult<double> At(A);
+    At.Transpose();
+    Matrix<double> grad = alias::fista::poisson::FuncGrad(Axu, At, b);
+    double grad_scale = b.Norm(one) / test_height;
+    bool optimality_test = x[dense_width + 1] == 0.0 && grad[dense_width + 1] > 0.0;
+    for(size_t i = 0; i < test_width; ++i)
+        if( !(i >= dense_width && x[i] == 0.0) )
+            optimality_test = optimality_test && std::abs(grad[i]) < 1e-6 * grad_scale;
+
+    bool test_result = gram_test && recovery_test && optimality_test;
+    std::cout << std::endl << (test_result ? "Success" : "Failure") << ", achieved ";
+    std::cout << recovery_error << " relative norm error on the recovery." << std::endl << std::endl;
+
+    return test_result;
+}
+
 void Time(size_t length)
 {
     std::cout << "FISTA test with big data : " << std::endl << std::endl;
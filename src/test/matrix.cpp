@@ -8,6 +8,9 @@
 ///
 
 #include "test/matrix.hpp"
+#include "utils/linearop/matrix/view.hpp"
+
+#include <random>
 
 namespace alias
 {
@@ -194,6 +197,14 @@ bool Shrink<std::complex<double>>()
     return true;
 }
 
+template <>
+bool Expression<std::complex<double>>()
+{
+    std::cout << "Expression test with complex<double> is not implemented" << std::endl;
+
+    return true;
+}
+
 bool Input()
 {
     std::cout << "Input test : ";
@@ -216,6 +227,208 @@ bool Input()
     return test_result;
 }
 
+bool InputBinaryFile()
+{
+    std::cout << "Binary file input test : ";
+
+    const Matrix<double> expected_result("data/test/test.data", 8, 8);
+    Matrix<double> input_test("data/test/test.alias");
+    Matrix<float> input_test_converted("data/test/test.alias");
+
+    bool test_result = input_test.Height() == 8 && input_test.Width() == 8 && Compare(expected_result, input_test);
+    test_result &= input_test_converted.Height() == 8 && IsEqual(input_test_converted[63], (float) expected_result[63]);
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool View()
+{
+    std::cout << "View test : ";
+
+    const Matrix<double> rect = RectMatrix<double>();
+    MatrixView<double> block = MatrixView<double>(rect).Block(0, 1, 2, 3);
+    double data[6] = {2,3,4,7,8,9};
+    const Matrix<double> expected_result(data, 6, 2, 3);
+    bool test_result = Compare(expected_result, block.Copy());
+
+    Matrix<double> row = MatrixView<double>(rect).Row(1).Borrow();
+    row *= 2.0;
+    test_result &= row.Data() == rect.Data() + 5 && IsEqual(rect[9], 20.0);
+    test_result &= block(1, 2) == 18.0;
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool Pool()
+{
+    std::cout << "Memory pool test : ";
+
+    MemoryPool& pool = MemoryPool::Instance();
+    size_t allocations_avoided_start = pool.AllocationsAvoided();
+    bool test_result = true;
+    {
+        MemoryPool::Scope scope;
+        double* first_data;
+        {
+            Matrix<double> first(1.0, 37, 3);
+            first_data = first.Data();
+            test_result &= (reinterpret_cast<size_t>(first_data) % MemoryPool::alignment) == 0;
+        }
+        Matrix<double> second(2.0, 37, 3);
+        test_result &= second.Data() == first_data;
+        test_result &= pool.AllocationsAvoided() == allocations_avoided_start + 1;
+    }
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool Reduction()
+{
+    std::cout << "Reduction test : ";
+
+    // long enough to be split among threads, not a multiple of the accumulators to exercise the tail
+    size_t length = 100003;
+    Matrix<double> first(length, 1);
+    Matrix<double> second(length, 1);
+    long double sum = 0, norm_one = 0, norm_two_squared = 0, inner = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < length; ++i)
+    {
+        first[i] = std::sin((double) i) * (1.0 + i % 7);
+        second[i] = std::cos((double) i);
+        sum += first[i];
+        norm_one += std::abs(first[i]);
+        norm_two_squared += first[i] * first[i];
+        inner += (long double) first[i] * second[i];
+        min = std::min(min, first[i]);
+        max = std::max(max, first[i]);
+    }
+
+    auto close = [](double actual, long double expected, long double scale){ return std::abs(actual - expected) <= 1e-12 * scale; };
+    reduction::Summary summary = first.Summarize();
+    bool test_result = close(first.Sum(), sum, norm_one)
+                    && close(first.Norm(one), norm_one, norm_one)
+                    && close(first.Norm(two_squared), norm_two_squared, norm_two_squared)
+                    && first.Norm(inf) == std::max(-min, max)
+                    && first.Min() == min
+                    && first.Max() == max
+                    && close(Inner(first, second), inner, norm_one)
+                    && close(summary.sum, sum, norm_one)
+                    && close(summary.norm_one, norm_one, norm_one)
+                    && close(summary.norm_two_squared, norm_two_squared, norm_two_squared)
+                    && summary.min == min
+                    && summary.max == max
+                    && summary.NormInf() == first.Norm(inf);
+
+    // shorter than the accumulators, reduced in order
+    double short_data[5] = {0.1, 0.2, 0.3, 0.4, 0.5};
+    const Matrix<double> short_vector(short_data, 5, 5, 1);
+    test_result &= short_vector.Sum() == 0.1 + 0.2 + 0.3 + 0.4 + 0.5;
+
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool CCLarge()
+{
+    std::cout << "Connected component test with several strips : ";
+
+    // not square and not a multiple of the strip height, small integers to get ties
+    size_t height = 517;
+    size_t width = 300;
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_int_distribution<int> distribution(-6, 4);
+    Matrix<double> raw_data(height, width);
+    for(size_t i = 0; i < raw_data.Length(); ++i)
+        raw_data[i] = std::max(distribution(generator), 0);
+
+    // reference flood fill, ties go to the lowest index
+    Matrix<double> expected_result(0.0, height, width);
+    std::vector<bool> marked(raw_data.Length(), false);
+    for(size_t start = 0; start < raw_data.Length(); ++start)
+    {
+        if( raw_data[start] == 0.0 || marked[start] )
+            continue;
+        marked[start] = true;
+        size_t max_index = start;
+        std::vector<size_t> points = {start};
+        while( ! points.empty() )
+        {
+            size_t point = points.back();
+            points.pop_back();
+            if( raw_data[point] > raw_data[max_index] || (raw_data[point] == raw_data[max_index] && point < max_index) )
+                max_index = point;
+            size_t row = point / width;
+            size_t col = point % width;
+            for(size_t neighbor_row = (row == 0 ? 0 : row-1); neighbor_row < std::min(row+2, height); ++neighbor_row)
+                for(size_t neighbor_col = (col == 0 ? 0 : col-1); neighbor_col < std::min(col+2, width); ++neighbor_col)
+                {
+                    size_t neighbor = neighbor_row*width + neighbor_col;
+                    if( raw_data[neighbor] != 0.0 && ! marked[neighbor] )
+                    {
+                        marked[neighbor] = true;
+                        points.push_back(neighbor);
+                    }
+                }
+        }
+        expected_result[max_index] = raw_data[max_index];
+    }
+
+    bool test_result = Compare(expected_result, raw_data.ConnectedComponentsMax());
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool CholeskyTest()
+{
+    std::cout << "Blocked Cholesky factorization test : ";
+
+    // several diagonal blocks, the last one partial
+    size_t n = 150;
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    Matrix<double> C(n, n);
+    for(size_t i = 0; i < C.Length(); ++i)
+        C[i] = distribution(generator);
+    Matrix<double> M = C.Transpose() * C;
+    for(size_t i = 0; i < n; ++i)
+        M[i*n + i] += (double) n;
+    Matrix<double> x(n, 1);
+    for(size_t i = 0; i < n; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> rhs = M * x;
+
+    Matrix<double> L(M);
+    bool test_result = Cholesky(L);
+    Matrix<double> solution(rhs);
+    CholeskySolve(L, solution);
+
+    double factor_error = (L * L.Transpose() - M).Norm(two) / M.Norm(two);
+    double solution_error = (solution - x).Norm(two) / x.Norm(two);
+    test_result = test_result && factor_error < 1e-12 && solution_error < 1e-12;
+    for(size_t i = 0; i < n; ++i)
+        for(size_t j = i + 1; j < n; ++j)
+            test_result = test_result && L[i*n + j] == 0.0;
+
+    // not positive definite
+    Matrix<double> indefinite(M);
+    indefinite[(n/2)*n + n/2] = -1.0;
+    test_result = test_result && !Cholesky(indefinite);
+
+    std::cout << (test_result ? "Success" : "Failure") << ", achieved " << factor_error << " relative error on the factorization and ";
+    std::cout << solution_error << " on the solution." << std::endl;
+
+    return test_result;
+}
+
 } // namespace matrix
 } // namespace test
 } // namespace alias
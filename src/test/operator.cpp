@@ -86,6 +86,44 @@ void ConvolutionTime(size_t data_length, size_t filter_length)
     std::cout << elapsed_time.count() << std::endl;
 }
 
+bool ConvolutionTestInterior()
+{
+    std::cout << "Convolution interior and border test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> picture(70, 83);
+    for(size_t i = 0; i < picture.Length(); ++i)
+        picture[i] = distribution(generator);
+
+    // a filter without symmetry, then its left-right symmetric version
+    Matrix<double> filter(9, 7);
+    for(size_t i = 0; i < filter.Length(); ++i)
+        filter[i] = distribution(generator);
+    Matrix<double> mirrored(9, 7);
+    for(size_t row = 0; row < 9; ++row)
+        for(size_t col = 0; col < 7; ++col)
+            mirrored[row*7 + col] = filter[row*7 + std::min(col, 6 - col)];
+
+    bool test_result = true;
+    for( const Matrix<double>* kernel : {&filter, &mirrored} )
+    {
+        Matrix<double> expected(0.0, 70, 83);
+        for(int row = 0; row < 70; ++row)
+            for(int col = 0; col < 83; ++col)
+                for(int filter_row = 0; filter_row < 9; ++filter_row)
+                    for(int filter_col = 0; filter_col < 7; ++filter_col)
+                        if( row + filter_row - 4 >= 0 && row + filter_row - 4 < 70 && col + filter_col - 3 >= 0 && col + filter_col - 3 < 83 )
+                            expected[row*83 + col] += picture[(row + filter_row - 4)*83 + col + filter_col - 3] * (*kernel)[filter_row*7 + filter_col];
+        test_result = Compare(expected, Convolution<double>(*kernel) * picture) && test_result;
+    }
+
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 bool AbelTestBuild()
 {
     std::cout << "Abel transform build test : ";
@@ -98,10 +136,10 @@ bool AbelTestBuild()
 
     AbelTransform<double> K(8, 64, 4);
 #ifdef VERBOSE
-    std::cout << "Computed result :" << std::setprecision(16) << K.Data();
+    std::cout << "Computed result :" << std::setprecision(16) << K.Unpack();
 #endif // VERBOSE
 
-    bool test_result = Compare(result, K.Data());
+    bool test_result = Compare(result, K.Unpack());
     std::cout << (test_result ? "Success" : "Failure") << std::endl;
 
     return test_result;
@@ -119,7 +157,7 @@ bool AbelTestApply()
 
     AbelTransform<double> K(4, 16, 2);
 #ifdef VERBOSE
-    std::cout << std::endl << "Reduced Abel matrix :" << K.Data();
+    std::cout << std::endl << "Reduced Abel matrix :" << K.Unpack();
 #endif // VERBOSE
 
     double result_data[16] = {35.822462949689758L, 36.137596788175713L, 36.137596788175713L, 35.822462949689758L, 39.241542045876251L, 36.476063612607106L, 36.476063612607106L, 39.241542045876251L, 23.951000180045721L, 41.068373881823092L, 41.068373881823092L, 23.951000180045721L,  21.864171789035566L, 35.353852846400969L, 35.353852846400969L, 21.864171789035566L};
@@ -151,7 +189,7 @@ bool AbelTestApply2()
 
     AbelTransform<double> K(8, 64, 4);
 #ifdef VERBOSE
-    std::cout << std::endl << "Reduced Abel matrix :" << K.Data();
+    std::cout << std::endl << "Reduced Abel matrix :" << K.Unpack();
 #endif // VERBOSE
 
     double result_data[64] = {55.2091781708536L, 74.5257769312451L, 83.8743674549772L, 86.7125397023462L, 86.7125397023462L, 83.8743674549772L, 74.5257769312451L, 55.2091781708536L, 70.6454413490365L, 86.4511102292221L, 76.7416719077964L, 75.4773408312152L, 75.4773408312152L, 76.7416719077964L, 86.4511102292221L, 70.6454413490365L, 78.6024741678198L,  78.045056282331L, 74.5269613442854L, 79.2884777040187L, 79.2884777040187L, 74.5269613442854L,  78.045056282331L, 78.6024741678198L, 81.0097015312481L,  76.545008220707L, 78.5747410868872L, 81.2529885370636L, 81.2529885370636L, 78.5747410868872L,  76.545008220707L, 81.0097015312481L,  85.385381075195L, 96.4765836608538L, 91.7939939929231L, 86.6443107018285L, 86.6443107018285L, 91.7939939929231L, 96.4765836608538L,  85.385381075195L,  83.135371388058L, 94.9390754749439L, 100.915483980938L, 90.3207764186881L, 90.3207764186881L, 100.915483980938L, 94.9390754749439L,  83.135371388058L, 75.8977291309801L,  90.534286874125L,  96.228090669534L,  98.226749189087L,  98.226749189087L,  96.228090669534L, 90.534286874125L, 75.8977291309801L, 62.0541744543622L, 79.3796977339534L, 88.0866186934524L, 90.7834465749937L, 90.7834465749937L, 88.0866186934524L, 79.3796977339534L, 62.0541744543622L};
@@ -183,7 +221,7 @@ bool AbelTestTransposed()
 
     AbelTransform<double> K = AbelTransform<double>(4, 16, 2).Transpose();
 #ifdef VERBOSE
-    std::cout << std::endl << "Reduced Abel matrix :" << K.Data();
+    std::cout << std::endl << "Reduced Abel matrix :" << K.Unpack();
 #endif // VERBOSE
 
     double result_data[4] = {140.158514836875L, 46.208797155969L, 30.5667725857632L, 139.337069897935L};
@@ -215,7 +253,7 @@ bool AbelTestTransposed2()
 
     AbelTransform<double> K = AbelTransform<double>(8, 64, 4).Transpose();
 #ifdef VERBOSE
-    std::cout << std::endl << "Reduced Abel matrix :" << K.Data();
+    std::cout << std::endl << "Reduced Abel matrix :" << K.Unpack();
 #endif // VERBOSE
 
     double result_data[8] = {619.382195686487L, 619.524561482076L, 337.443035970858L, 68.7231225286759L, 41.460354182176L, 264.814515081461L, 640.807956259755L, 604.932952016532L};
@@ -235,11 +273,11 @@ bool AbelTestTransposed2()
     return test_result;
 }
 
-void AbelTime(size_t pic_size)
+void AbelTime(size_t pic_size, AbelStorage storage)
 {
-    std::cout << "Abel time : ";
+    std::cout << "Abel time (storage " << storage << ") : ";
 
-    AbelTransform<double> K(pic_size, pic_size*pic_size, pic_size/2);
+    AbelTransform<double> K(pic_size, pic_size*pic_size, pic_size/2, storage);
 
     std::default_random_engine generator;
     generator.seed(123456789);
@@ -281,6 +319,103 @@ void AbelTime(size_t pic_size)
     std::cout << elapsed_time.count() << " seconds" << std::endl;
 }
 
+bool AbelTestMultiple()
+{
+    std::cout << "Abel transform multiple columns test : ";
+
+    AbelTransform<double> K(32, 32*32, 16);
+    AbelTransform<double> Kt = AbelTransform<double>(K).Transpose();
+
+    // more columns than a tile so that the last one is partial
+    const size_t columns = 70;
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> signal(32, columns);
+    for(size_t i = 0; i < signal.Length(); ++i)
+        signal[i] = distribution(generator);
+    Matrix<double> picture(32*32, columns);
+    for(size_t i = 0; i < picture.Length(); ++i)
+        picture[i] = distribution(generator);
+
+    Matrix<double> computed = K*signal;
+    Matrix<double> computed_transposed = Kt*picture;
+
+    // every column against the single column kernels
+    Matrix<double> expected(32*32, columns);
+    Matrix<double> expected_transposed(32, columns);
+    for(size_t col = 0; col < columns; ++col)
+    {
+        Matrix<double> column(32, 1);
+        for(size_t row = 0; row < 32; ++row)
+            column[row] = signal[row*columns + col];
+        Matrix<double> product = K*column;
+        for(size_t row = 0; row < 32*32; ++row)
+            expected[row*columns + col] = product[row];
+
+        Matrix<double> column_transposed(32*32, 1);
+        for(size_t row = 0; row < 32*32; ++row)
+            column_transposed[row] = picture[row*columns + col];
+        Matrix<double> product_transposed = Kt*column_transposed;
+        for(size_t row = 0; row < 32; ++row)
+            expected_transposed[row*columns + col] = product_transposed[row];
+    }
+
+    bool test_result = Compare(expected, computed);
+    test_result = Compare(expected_transposed, computed_transposed) && test_result;
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool AbelTestStorage()
+{
+    std::cout << "Abel transform storage test : ";
+
+    AbelTransform<double> K(64, 64*64, 32);
+    AbelTransform<double> K_single(64, 64*64, 32, abel_single);
+    AbelTransform<double> K_bfloat16(64, 64*64, 32, abel_bfloat16);
+    AbelTransform<double> K_on_the_fly(64, 64*64, 32, abel_on_the_fly);
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> signal(64, 1);
+    for(size_t i = 0; i < signal.Length(); ++i)
+        signal[i] = distribution(generator);
+    Matrix<double> picture(64*64, 1);
+    for(size_t i = 0; i < picture.Length(); ++i)
+        picture[i] = distribution(generator);
+
+    // the packed rows hold less than the dense compressed matrix, the reduced precisions less again
+    size_t dense_bytes = 64*64/4 * 64/2 * sizeof(double);
+    bool test_result = K.Table().Bytes() < dense_bytes;
+    test_result = K_single.Table().Bytes() < K.Table().Bytes() && K_bfloat16.Table().Bytes() < K_single.Table().Bytes() && test_result;
+
+    // computing the elements gives the stored ones back, from the geometry only
+    test_result = K_on_the_fly.Table().Bytes() == (32 + 32 + 32)*sizeof(double) && test_result;
+    test_result = Compare(K.Unpack(), K_on_the_fly.Unpack()) && test_result;
+
+    // the reduced precisions only lose the rounding of the stored elements
+    Matrix<double> expected = K*signal;
+    Matrix<double> expected_transposed = AbelTransform<double>(K).Transpose()*picture;
+    double error_single = (K_single*signal - expected).Norm(two) / expected.Norm(two);
+    double error_bfloat16 = (K_bfloat16*signal - expected).Norm(two) / expected.Norm(two);
+    double error_single_transposed = (K_single.Transpose()*picture - expected_transposed).Norm(two) / expected_transposed.Norm(two);
+    double error_bfloat16_transposed = (K_bfloat16.Transpose()*picture - expected_transposed).Norm(two) / expected_transposed.Norm(two);
+#ifdef VERBOSE
+    std::cout << std::endl << "Relative errors : " << error_single << " " << error_bfloat16 << " " << error_single_transposed << " " << error_bfloat16_transposed << std::endl;
+#endif // VERBOSE
+    test_result = error_single < 1e-6 && error_single_transposed < 1e-6 && test_result;
+    test_result = error_bfloat16 < 1e-2 && error_bfloat16_transposed < 1e-2 && test_result;
+    test_result = Compare(expected, K_on_the_fly*signal) && test_result;
+    test_result = Compare(expected_transposed, K_on_the_fly.Transpose()*picture) && test_result;
+
+    std::cout << (test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 bool WaveletTest()
 {
     std::cout << "Wavelet transform test : ";
@@ -410,10 +545,11 @@ bool SplineTest()
 
     Spline<double> king = Spline<double>(8).Transpose();
 #ifdef VERBOSE
-    std::cout << std::endl << "Computed result :" << king.Data();
+    std::cout << std::endl << "Computed result :" << king.Data().Transpose();
 #endif // VERBOSE
 
-    bool test_result = Compare(expected_result, king.Data());
+    // the storage keeps the forward orientation
+    bool test_result = Compare(expected_result, king.Data().Transpose());
 
     std::cout << ( test_result ? "Success" : "Failure") << std::endl;
 
@@ -432,7 +568,7 @@ bool BlurTest()
     double result_data[25] = {12,12,9,6,-12,-12,0,0,0,-30,-27,0,0,0,-45,-42,0,0,0,-60,-108,-78,-81,-84,-132};
     Matrix<double> expected_result(result_data, 25, 5, 5);
 
-    Blurring<double> blur(filter, 5);
+    Blurring<double> blur(filter, 5, blurring_convolution);
 
     bool test_result = Compare(expected_result, blur * data);
 
@@ -441,6 +577,127 @@ bool BlurTest()
     return test_result;
 }
 
+bool BlurBackendTest()
+{
+    std::cout << "Blur backends test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> picture(64, 64);
+    for(size_t i = 0; i < picture.Length(); ++i)
+        picture[i] = distribution(generator);
+    Matrix<double> filter(7, 7);
+    for(size_t i = 0; i < filter.Length(); ++i)
+        filter[i] = distribution(generator);
+
+    // both backends correlate with the filter as given, even when it is not symmetric
+    Blurring<double> direct(filter, 64, blurring_convolution);
+    Blurring<double> fourier(filter, 64, blurring_fourier);
+    Matrix<double> expected = direct * picture;
+    double error = (fourier * picture - expected).Norm(two) / expected.Norm(two);
+#ifdef VERBOSE
+    std::cout << std::endl << "Relative error : " << error << std::endl;
+#endif // VERBOSE
+    bool test_result = direct.Backend() == blurring_convolution && fourier.Backend() == blurring_fourier && error < 1e-12;
+
+    // the measured choice is one of the backends and is reused for the same sizes
+    Blurring<double> automatic(filter, 64);
+    test_result = automatic.Backend() != blurring_auto && Blurring<double>(filter, 64).Backend() == automatic.Backend() && test_result;
+    Matrix<double> computed = automatic * picture;
+    test_result = (computed - expected).Norm(two) / expected.Norm(two) < 1e-12 && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool SeparableConvolutionTest()
+{
+    std::cout << "Separable convolution test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> picture(64, 64);
+    for(size_t i = 0; i < picture.Length(); ++i)
+        picture[i] = distribution(generator);
+
+    // a filter of rank two is found with two terms, up to the rounding of the others
+    Matrix<double> column_0(9, 1), row_0(1, 7), column_1(9, 1), row_1(1, 7);
+    for(size_t i = 0; i < 9; ++i)
+    {
+        column_0[i] = distribution(generator);
+        column_1[i] = distribution(generator);
+    }
+    for(size_t j = 0; j < 7; ++j)
+    {
+        row_0[j] = distribution(generator);
+        row_1[j] = distribution(generator);
+    }
+    Matrix<double> filter(9, 7);
+    for(size_t i = 0; i < 9; ++i)
+        for(size_t j = 0; j < 7; ++j)
+            filter[i*7 + j] = column_0[i]*row_0[j] + column_1[i]*row_1[j];
+    SeparableConvolution<double> separable(filter, 1e-12);
+    Matrix<double> expected = Convolution<double>(filter) * picture;
+    double error = (separable * picture - expected).Norm(two) / expected.Norm(two);
+    bool test_result = separable.Rank() == 2 && separable.Error() < 1e-12 && error < 1e-12;
+
+    // the power law filter needs a few terms only, the error on the result follows the one on the filter
+    Matrix<double> psf = Blurring<double>().Generate(1e-3, 4.0, 1.5);
+    Blurring<double> direct(psf, 64, blurring_convolution);
+    Blurring<double> approximated(psf, 64, blurring_separable, 1e-3);
+    expected = direct * picture;
+    error = (approximated * picture - expected).Norm(two) / expected.Norm(two);
+#ifdef VERBOSE
+    std::cout << std::endl << "Filter size " << psf.Width() << ", rank " << approximated.Separable().Rank() << ", filter error " << approximated.Separable().Error() << ", result error " << error << std::endl;
+#endif // VERBOSE
+    test_result = approximated.Separable().Rank() < psf.Width()/2 && approximated.Separable().Error() <= 1e-3 && error < 1e-3 && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool HybridTest()
+{
+    std::cout << "Hybrid dense and sparse operator test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_int_distribution distribution(-100,100);
+    size_t test_height = 40;
+    size_t test_width = 12;
+    size_t dense_width = 4;
+
+    // dense leading columns, then columns with a small support as the point sources
+    Matrix<double> A(0.0, test_height, test_width);
+    for(size_t col = 0; col < test_width; ++col)
+        for(size_t row = 0; row < test_height; ++row)
+            if( col < dense_width || (row + 3*col) % 7 == 0 )
+                A[row*test_width + col] = distribution(generator);
+    Matrix<double> x(test_width, 1);
+    for(size_t i = 0; i < test_width; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> y(test_height, 1);
+    for(size_t i = 0; i < test_height; ++i)
+        y[i] = distribution(generator);
+
+    MatMult<double> dense(A, test_height, test_width);
+    HybridMatMult<double> hybrid(test_height, test_width, dense_width,
+                                 [&](size_t col){ return MatrixView<double>(A).Block(0, col, test_height, 1).Copy(); });
+
+    bool test_result = Compare(dense * x, hybrid * x);
+    dense.Transpose();
+    hybrid.Transpose();
+    test_result = Compare(dense * y, hybrid * y) && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 bool FourierTest()
 {
     std::cout << "Fourier test : ";
@@ -456,6 +713,98 @@ bool FourierTest()
     return true;
 }
 
+bool FourierTestDFT()
+{
+    std::cout << "Fourier DFT test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    // odd and even depths, against the sum defining the transform
+    bool test_result = true;
+    for(size_t length = 2; length <= 256; length *= 2)
+    {
+        Fourier<double> fourier(length);
+        Matrix<std::complex<double>> signal(length, 1);
+        for(size_t i = 0; i < length; ++i)
+            signal[i] = std::complex<double>(distribution(generator), distribution(generator));
+
+        Matrix<std::complex<double>> transform(length, 1);
+        Matrix<std::complex<double>> inverse(length, 1);
+        fourier.FFT(signal, transform);
+        fourier.IFFT(transform, inverse);
+
+        double error = 0.0, inverse_error = 0.0, norm = 0.0;
+        for(size_t k = 0; k < length; ++k)
+        {
+            std::complex<double> expected = 0.0;
+            for(size_t n = 0; n < length; ++n)
+                expected += signal[n] * std::polar(1.0, -2.0 * PI * ((n*k) % length) / length);
+            error = std::max(error, std::abs(transform[k] - expected));
+            inverse_error = std::max(inverse_error, std::abs(inverse[k] - signal[k]));
+            norm = std::max(norm, std::abs(expected));
+        }
+        test_result = error < 1e-14 * norm * std::log2(length) && inverse_error < 1e-14 * std::log2(length) && test_result;
+    }
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool FourierTestReal()
+{
+    std::cout << "Fourier real signal test : ";
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    // odd sizes leave a row without a pair and a spectrum column without its mirror
+    const size_t length = 32;
+    Fourier<double> fourier(length);
+    Matrix<double> signal(13, 11);
+    Matrix<std::complex<double>> complex_signal(13, 11);
+    for(size_t i = 0; i < signal.Length(); ++i)
+        complex_signal[i] = signal[i] = distribution(generator);
+    Matrix<double> filter(5, 3);
+    for(size_t i = 0; i < filter.Length(); ++i)
+        filter[i] = distribution(generator);
+
+    // the stored columns are the ones of the complex transform
+    Matrix<std::complex<double>> expected_spectrum = fourier.FFT2D(complex_signal);
+    Matrix<std::complex<double>> spectrum(fourier.HalfWidth(), length);
+    fourier.RealFFT2D(signal, spectrum.Data(), Workspace::Local());
+    double error = 0.0, norm = 0.0;
+    for(size_t k = 0; k < fourier.HalfWidth(); ++k)
+        for(size_t row = 0; row < length; ++row)
+        {
+            error = std::max(error, std::abs(spectrum[k*length + row] - expected_spectrum[row*length + k]));
+            norm = std::max(norm, std::abs(expected_spectrum[row*length + k]));
+        }
+    bool test_result = error < 1e-13 * norm;
+
+    // a window of the cyclic convolution, against its defining sum
+    Matrix<std::complex<double>> filter_spectrum(fourier.HalfWidth(), length);
+    fourier.RealFFT2D(filter, filter_spectrum.Data(), Workspace::Local());
+    filter_spectrum *= std::complex<double>(1.0 / (length*length));
+    Matrix<double> computed(13, 11);
+    fourier.RealConvolution2D(signal, filter_spectrum.Data(), 2, 1, computed, Workspace::Local());
+    Matrix<double> expected((double) 0, 13, 11);
+    for(size_t row = 0; row < 13; ++row)
+        for(size_t col = 0; col < 11; ++col)
+            for(size_t i = 0; i < 5; ++i)
+                for(size_t j = 0; j < 3; ++j)
+                    if( row + 2 >= i && row + 2 - i < 13 && col + 1 >= j && col + 1 - j < 11 )
+                        expected[row*11 + col] += filter[i*3 + j] * signal[(row + 2 - i)*11 + col + 1 - j];
+    test_result = (computed - expected).Norm(two) / expected.Norm(two) < 1e-13 && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 bool AstroTest()
 {
     std::cout << "Astro operator test : ";
@@ -502,6 +851,231 @@ bool AstroTestTransposed()
     return test_result;
 }
 
+bool RestrictedTest()
+{
+    std::cout << "Restricted astro operator test : ";
+
+    Matrix<double> divx(std::string("data/test/divx.data"), 4224, 1, double());
+
+    Matrix<double> E(std::string("data/test/E.data"), 4096, 1, double());
+
+    AstroOperator astro(64, 64, 32, E, divx, false, WS::Parameters<double>());
+    AstroOperator astro_transp(64, 64, 32, E, divx, true, WS::Parameters<double>());
+
+    // support on the wavelet, spline and point source coefficients
+    size_t support_data[8] = {0, 5, 63, 64, 100, 128, 2000, 4223};
+    Matrix<size_t> support(support_data, 8, 8, 1);
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> x(8, 1);
+    for(size_t i = 0; i < 8; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> y(4096, 1);
+    for(size_t i = 0; i < 4096; ++i)
+        y[i] = distribution(generator);
+
+    Matrix<double> x_full(0.0, 4224, 1);
+    for(size_t i = 0; i < 8; ++i)
+        x_full[support[i]] = x[i];
+    Matrix<double> y_full = astro_transp * y;
+    Matrix<double> expected_transposed(8, 1);
+    for(size_t i = 0; i < 8; ++i)
+        expected_transposed[i] = y_full[support[i]];
+
+    RestrictedOperator<double> restricted(astro, support);
+    bool test_result = Compare(astro * x_full, restricted * x);
+    restricted.Transpose();
+    test_result = Compare(expected_transposed, restricted * y) && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool ApplyTest()
+{
+    std::cout << "Out-of-place application test : ";
+
+    Matrix<double> divx(std::string("data/test/divx.data"), 4224, 1, double());
+
+    Matrix<double> E(std::string("data/test/E.data"), 4096, 1, double());
+
+    AstroOperator astro(64, 64, 32, E, divx, false, WS::Parameters<double>());
+    AstroOperator astro_transp(64, 64, 32, E, divx, true, WS::Parameters<double>());
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> x(4224, 1);
+    for(size_t i = 0; i < 4224; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> y(4096, 1);
+    for(size_t i = 0; i < 4096; ++i)
+        y[i] = distribution(generator);
+
+    // results written in the middle of larger buffers
+    Workspace workspace;
+    Matrix<double> buffer_forward(-1.0, 4096 + 2, 1);
+    Matrix<double> buffer_transposed(-1.0, 4224 + 2, 1);
+    astro.Apply(x, MatrixView<double>(buffer_forward).Segment(1, 4096), workspace);
+    astro_transp.Apply(y, MatrixView<double>(buffer_transposed).Segment(1, 4224), workspace);
+    size_t allocations = workspace.Allocations();
+
+    bool test_result = Compare(astro * x, MatrixView<double>(buffer_forward).Segment(1, 4096).Copy());
+    test_result = Compare(astro_transp * y, MatrixView<double>(buffer_transposed).Segment(1, 4224).Copy()) && test_result;
+    test_result = buffer_forward[0] == -1.0 && buffer_forward[4097] == -1.0 && test_result;
+    test_result = buffer_transposed[0] == -1.0 && buffer_transposed[4225] == -1.0 && test_result;
+
+    // the memory of the first applications is reused
+    for(size_t i = 0; i < 3; ++i)
+    {
+        astro.Apply(x, MatrixView<double>(buffer_forward).Segment(1, 4096), workspace);
+        astro_transp.Apply(y, MatrixView<double>(buffer_transposed).Segment(1, 4224), workspace);
+    }
+    test_result = allocations != 0 && workspace.Allocations() == allocations && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool SharedStateTest()
+{
+    std::cout << "Shared operator state test : ";
+
+    Matrix<double> divx(std::string("data/test/divx.data"), 4224, 1, double());
+
+    Matrix<double> E(std::string("data/test/E.data"), 4096, 1, double());
+
+    AstroOperator astro(64, 64, 32, E, divx, false, WS::Parameters<double>());
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> x(4224, 1);
+    for(size_t i = 0; i < 4224; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> expected = astro * x;
+
+    // the clone points to the same tables
+    Operator<double>* clone = astro.Clone();
+    AstroOperator<double>& astro_clone = *static_cast<AstroOperator<double>*>(clone);
+    bool test_result = astro_clone.Sensitivity().Data() == astro.Sensitivity().Data();
+    test_result = astro_clone.Standardize().Data() == astro.Standardize().Data() && test_result;
+    test_result = &astro_clone.Abel().Table() == &astro.Abel().Table() && test_result;
+    test_result = astro_clone.SplineOp().Data().Data() == astro.SplineOp().Data().Data() && test_result;
+
+    // mutating the clone leaves the original untouched, transposing it moves no table
+    astro_clone.Standardize(Matrix<double>(2.0, 4224, 1));
+    astro_clone.Transpose();
+    test_result = astro.Standardize().Data() != astro_clone.Standardize().Data() && test_result;
+    test_result = &astro.Abel().Table() == &astro_clone.Abel().Table() && test_result;
+    test_result = astro.SplineOp().Data().Data() == astro_clone.SplineOp().Data().Data() && test_result;
+    test_result = Compare(expected, astro * x) && test_result;
+    delete clone;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool TransposeFlagTest()
+{
+    std::cout << "Transposition without data movement test : ";
+
+    Matrix<double> divx(std::string("data/test/divx.data"), 4224, 1, double());
+
+    Matrix<double> E(std::string("data/test/E.data"), 4096, 1, double());
+
+    AstroOperator astro(64, 64, 32, E, divx, false, WS::Parameters<double>());
+    AstroOperator astro_transp(64, 64, 32, E, divx, true, WS::Parameters<double>());
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> x(4224, 1);
+    for(size_t i = 0; i < 4224; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> y(4096, 1);
+    for(size_t i = 0; i < 4096; ++i)
+        y[i] = distribution(generator);
+    Matrix<double> expected = astro * x;
+
+    // the flipped operator keeps the tables of the forward one and matches the one built transposed
+    const AbelTransform<double>::Packed* abel = &astro.Abel().Table();
+    const double* spline = astro.SplineOp().Data().Data();
+    astro.Transpose();
+    bool test_result = &astro.Abel().Table() == abel && astro.SplineOp().Data().Data() == spline;
+    test_result = Compare(astro_transp * y, astro * y) && test_result;
+    astro.Transpose();
+    test_result = Compare(expected, astro * x) && test_result;
+
+    // dense operators against their explicitly transposed matrix
+    Matrix<double> data(7, 5);
+    for(size_t i = 0; i < data.Length(); ++i)
+        data[i] = distribution(generator);
+    MatMult<double> dense(data, 7, 5);
+    const double* storage = dense.Data().Data();
+    dense.Transpose();
+    Matrix<double> z(7, 1);
+    for(size_t i = 0; i < z.Length(); ++i)
+        z[i] = distribution(generator);
+    test_result = dense.Data().Data() == storage && Compare(data.Transpose() * z, dense * z) && test_result;
+    Matrix<double> applied(5, 1);
+    dense.Apply(z, applied, Workspace::Local());
+    test_result = Compare(data.Transpose() * z, applied) && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
+bool AbelSplineTest()
+{
+    std::cout << "Precomposed Abel transform and spline test : ";
+
+    Matrix<double> divx(std::string("data/test/divx.data"), 4224, 1, double());
+
+    Matrix<double> E(std::string("data/test/E.data"), 4096, 1, double());
+
+    WS::Parameters<double> params;
+    params.precompose_spline = true;
+    AstroOperator astro(64, 64, 32, E, divx, false, WS::Parameters<double>());
+    AstroOperator astro_transp(64, 64, 32, E, divx, true, WS::Parameters<double>());
+    AstroOperator astro_composed(64, 64, 32, E, divx, false, params);
+    AstroOperator astro_composed_transp(64, 64, 32, E, divx, true, params);
+
+    std::default_random_engine generator;
+    generator.seed(123456789);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    Matrix<double> x(4224, 1);
+    for(size_t i = 0; i < 4224; ++i)
+        x[i] = distribution(generator);
+    Matrix<double> y(4096, 1);
+    for(size_t i = 0; i < 4096; ++i)
+        y[i] = distribution(generator);
+
+    // full products, then the spline coefficients alone which skip the Abel transform
+    bool test_result = astro_composed.IsPrecomposed() && !astro.IsPrecomposed();
+    test_result = Compare(astro * x, astro_composed * x) && test_result;
+    test_result = Compare(astro_transp * y, astro_composed_transp * y) && test_result;
+    test_result = Compare(astro.BAW(x, true, false, true, false), astro_composed.BAW(x, true, false, true, false)) && test_result;
+    test_result = Compare(astro_transp.WtAtBt(y, true, false, true, true), astro_composed_transp.WtAtBt(y, true, false, true, true)) && test_result;
+
+    // the composed table follows the transposition and the new sub-operators
+    astro_composed.Transpose();
+    test_result = Compare(astro_transp * y, astro_composed * y) && test_result;
+    astro_composed.Transpose();
+    astro_composed.Abel(AbelTransform<double>(64, 64*64, 32, abel_on_the_fly));
+    test_result = Compare(astro * x, astro_composed * x) && test_result;
+
+    std::cout << ( test_result ? "Success" : "Failure") << std::endl;
+
+    return test_result;
+}
+
 } // namespace oper
 } // namespace test
 } // namespace alias